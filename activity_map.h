@@ -0,0 +1,96 @@
+#ifndef ACTIVITY_MAP_H
+#define ACTIVITY_MAP_H
+
+#include <algorithm>
+#include <vector>
+#include "grid_traversal.h"
+
+// per-tile activity of the grid: square tiles of tileSize cells, aligned to cell (0, 0).
+// the simulator marks tiles once per step between beginUpdate() and endUpdate(); the
+// row loops below then visit only the tiles in one state, clipped to a cell range and
+// handed out with a static OpenMP schedule like GridTraversal:
+//
+//     span(int j, int iBegin, int iEnd)
+//
+// the previous step's state is kept, so kernels can clean up tiles that just went quiet
+class ActivityMap {
+public:
+    ActivityMap() : tileSize(16), tilesX(0), tilesY(0) {}
+
+    void resize(int gridX, int gridY, int tileSize) {
+        this->tileSize = std::max(1, tileSize);
+        tilesX = (gridX + this->tileSize - 1) / this->tileSize;
+        tilesY = (gridY + this->tileSize - 1) / this->tileSize;
+        active.assign(tileCount(), 1);
+        wasActive = active;
+        rebuildLists();
+    }
+
+    int getTileSize() const { return tileSize; }
+    int getTilesX() const { return tilesX; }
+    int getTilesY() const { return tilesY; }
+    int tileCount() const { return tilesX * tilesY; }
+    bool isActive(int tileX, int tileY) const { return active[tileY * tilesX + tileX] != 0; }
+
+    // cells of a tile, not clipped to the grid
+    CellRange tileCells(int tile) const {
+        int i = (tile % tilesX) * tileSize;
+        int j = (tile / tilesX) * tileSize;
+        return {i, i + tileSize, j, j + tileSize};
+    }
+
+    void beginUpdate() { wasActive.swap(active); }
+    void setActive(int tile, bool state) { active[tile] = state ? 1 : 0; }
+    void endUpdate() { rebuildLists(); }
+
+    float activeFraction() const {
+        return tileCount() > 0 ? static_cast<float>(activeTiles.size()) / tileCount() : 1.0f;
+    }
+
+    template <typename Span>
+    void forEachActiveRow(const CellRange& range, Span&& span) const { forEachRowOf(activeTiles, range, span); }
+    template <typename Span>
+    void forEachInactiveRow(const CellRange& range, Span&& span) const { forEachRowOf(inactiveTiles, range, span); }
+    // tiles that were active in the previous step and are inactive now
+    template <typename Span>
+    void forEachDeactivatedRow(const CellRange& range, Span&& span) const { forEachRowOf(deactivatedTiles, range, span); }
+
+private:
+    int tileSize;
+    int tilesX, tilesY;
+    std::vector<unsigned char> active;
+    std::vector<unsigned char> wasActive;
+    std::vector<int> activeTiles, inactiveTiles, deactivatedTiles;
+
+    void rebuildLists() {
+        activeTiles.clear();
+        inactiveTiles.clear();
+        deactivatedTiles.clear();
+        for (int tile = 0; tile < tileCount(); tile++) {
+            if (active[tile]) {
+                activeTiles.push_back(tile);
+            } else {
+                inactiveTiles.push_back(tile);
+                if (wasActive[tile]) deactivatedTiles.push_back(tile);
+            }
+        }
+    }
+
+    template <typename Span>
+    void forEachRowOf(const std::vector<int>& tiles, const CellRange& range, Span& span) const {
+        const int count = static_cast<int>(tiles.size());
+        #pragma omp parallel for schedule(static)
+        for (int n = 0; n < count; n++) {
+            CellRange cells = tileCells(tiles[n]);
+            int iBegin = std::max(cells.iBegin, range.iBegin);
+            int iEnd = std::min(cells.iEnd, range.iEnd);
+            if (iEnd <= iBegin) continue;
+            int jEnd = std::min(cells.jEnd, range.jEnd);
+            for (int j = std::max(cells.jBegin, range.jBegin); j < jEnd; j++) {
+                span(j, iBegin, iEnd);
+            }
+        }
+    }
+};
+
+#endif
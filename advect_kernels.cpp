@@ -0,0 +1,651 @@
+#include "advect_kernels.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KATARA_X86_SIMD 1
+#include <immintrin.h>
+// avx512f implies fma; keep mul/add separate so all kernels round the same way
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// note: the vector kernels repeat the scalar arithmetic in the same order,
+// so every ISA produces bit-identical fields
+
+namespace {
+
+template <typename Real, typename T>
+inline Real interpolate(const T* field, const BasicSampleWeights<Real>& w) {
+    return w.w00 * toFloat(field[w.i00]) +
+           w.w10 * toFloat(field[w.i10]) +
+           w.w11 * toFloat(field[w.i11]) +
+           w.w01 * toFloat(field[w.i01]);
+}
+
+// Real is the simulator's scalar type, T the passive scalar storage (float, Half, BFloat16);
+// HasInk = false assumes no scalar is ink and compiles the ink masking out
+template <typename Real, typename T, bool HasInk>
+void advectRowScalarT(const BasicAdvectionFields<Real>& f, int j, int iBegin, int iEnd) {
+    const int stride = f.stride;
+    const Real* u = f.u;
+    const Real* v = f.v;
+    const uint8_t* flags = f.flags;
+    const bool inkRow = HasInk && j >= f.inkSkipRowBegin && j < f.inkSkipRowEnd;
+
+    const T* scalars[MAX_PASSIVE_SCALARS];
+    T* scalarsNext[MAX_PASSIVE_SCALARS];
+    for (int n = 0; n < f.scalarCount; n++) {
+        scalars[n] = static_cast<const T*>(f.scalars[n]);
+        scalarsNext[n] = static_cast<T*>(f.scalarsNext[n]);
+    }
+
+    for (int i = iBegin; i < iEnd; i++) {
+        int k = f.origin + j * stride + i;
+
+        f.uNext[k] = u[k];
+        f.vNext[k] = v[k];
+        for (int n = 0; n < f.scalarCount; n++) {
+            scalarsNext[n][k] = scalars[n][k];
+        }
+
+        if (!(flags[k] & CELL_FLUID)) continue;
+
+        // x vel advection
+        if ((flags[k] & CELL_XM) && j < f.gridY-1) {
+            Real x0 = i * f.cellHeight;
+            Real y0 = j * f.cellHeight + f.halfCellHeight;
+            x0 -= u[k] * f.timeStep;
+            y0 -= (v[k-1] + v[k] + v[k-1+stride] + v[k+stride]) / 4.0f * f.timeStep;
+            f.uNext[k] = f.sampler.template sample<Staggering::U_FACE>(u, x0, y0);
+        }
+
+        // y vel advection
+        if ((flags[k] & CELL_YM) && i < f.gridX-1) {
+            Real x0 = i * f.cellHeight + f.halfCellHeight;
+            Real y0 = j * f.cellHeight;
+            x0 -= (u[k-stride] + u[k] + u[k+1-stride] + u[k+1]) / 4.0f * f.timeStep;
+            y0 -= v[k] * f.timeStep;
+            f.vNext[k] = f.sampler.template sample<Staggering::V_FACE>(v, x0, y0);
+        }
+
+        // smoke and ink advection: one backtrace and one set of weights for all scalars
+        Real velX = (u[k] + u[k+1]) / 2.0f;
+        Real velY = (v[k] + v[k+stride]) / 2.0f;
+        Real x1 = i * f.cellHeight + f.halfCellHeight - velX * f.timeStep;
+        Real y1 = j * f.cellHeight + f.halfCellHeight - velY * f.timeStep;
+        BasicSampleWeights<Real> weights = f.sampler.template weights<Staggering::CELL_CENTER>(x1, y1);
+
+        bool skipInk = false;
+        if (HasInk) {
+            bool noInk = true;
+            for (int n = 0; n < f.scalarCount; n++) {
+                if (f.scalarIsInk[n] && toFloat(scalars[n][k]) != 0.0f) noInk = false;
+            }
+            skipInk = (i == 1 && inkRow) || noInk;
+        }
+
+        for (int n = 0; n < f.scalarCount; n++) {
+            if (HasInk && f.scalarIsInk[n] && skipInk) continue;
+            scalarsNext[n][k] = fromFloat<T>(static_cast<float>(interpolate(scalars[n], weights)));
+        }
+    }
+}
+
+} // namespace
+
+template <typename Real>
+void advectRowScalar(const BasicAdvectionFields<Real>& f, int j, int iBegin, int iEnd) {
+    switch (f.scalarPrecision) {
+        case ScalarPrecision::FP16: advectRowScalarT<Real, Half, true>(f, j, iBegin, iEnd); break;
+        case ScalarPrecision::BF16: advectRowScalarT<Real, BFloat16, true>(f, j, iBegin, iEnd); break;
+        default: advectRowScalarT<Real, float, true>(f, j, iBegin, iEnd); break;
+    }
+}
+
+template void advectRowScalar<float>(const BasicAdvectionFields<float>&, int, int, int);
+template void advectRowScalar<double>(const BasicAdvectionFields<double>&, int, int, int);
+
+#ifdef KATARA_X86_SIMD
+namespace {
+
+// AVX2: 8 cells per iteration
+
+struct Weights8 {
+    __m256i i00, i10, i01, i11;
+    __m256 w00, w10, w01, w11;
+};
+
+template <Staggering S>
+__attribute__((target("avx2")))
+inline Weights8 weights8(const GridSampler& g, __m256 px, __m256 py) {
+    const __m256 h = _mm256_set1_ps(g.cellHeight);
+    const __m256 xOffset = _mm256_set1_ps(StaggerOffset<S>::x * g.cellHeight);
+    const __m256 yOffset = _mm256_set1_ps(StaggerOffset<S>::y * g.cellHeight);
+    const __m256i one = _mm256_set1_epi32(1);
+
+    px = _mm256_min_ps(_mm256_max_ps(px, h), _mm256_set1_ps(g.xHeight));
+    py = _mm256_min_ps(_mm256_max_ps(py, h), _mm256_set1_ps(g.yHeight));
+    __m256 rx = _mm256_sub_ps(px, xOffset);
+    __m256 ry = _mm256_sub_ps(py, yOffset);
+
+    // as in GridSampler::weights, x1/y1 may land in the high ghost layers
+    __m256i x0 = _mm256_cvttps_epi32(_mm256_div_ps(rx, h));
+    __m256i x1 = _mm256_add_epi32(x0, one);
+    __m256i y0 = _mm256_cvttps_epi32(_mm256_div_ps(ry, h));
+    __m256i y1 = _mm256_add_epi32(y0, one);
+
+    __m256 tx = _mm256_div_ps(_mm256_sub_ps(rx, _mm256_mul_ps(_mm256_cvtepi32_ps(x0), h)), h);
+    __m256 ty = _mm256_div_ps(_mm256_sub_ps(ry, _mm256_mul_ps(_mm256_cvtepi32_ps(y0), h)), h);
+    __m256 sx = _mm256_sub_ps(_mm256_set1_ps(1.0f), tx);
+    __m256 sy = _mm256_sub_ps(_mm256_set1_ps(1.0f), ty);
+
+    const __m256i stride = _mm256_set1_epi32(g.stride);
+    const __m256i origin = _mm256_set1_epi32(g.origin);
+    __m256i row0 = _mm256_add_epi32(_mm256_mullo_epi32(y0, stride), origin);
+    __m256i row1 = _mm256_add_epi32(_mm256_mullo_epi32(y1, stride), origin);
+
+    Weights8 w;
+    w.i00 = _mm256_add_epi32(row0, x0);
+    w.i10 = _mm256_add_epi32(row0, x1);
+    w.i01 = _mm256_add_epi32(row1, x0);
+    w.i11 = _mm256_add_epi32(row1, x1);
+    w.w00 = _mm256_mul_ps(sx, sy);
+    w.w10 = _mm256_mul_ps(tx, sy);
+    w.w01 = _mm256_mul_ps(sx, ty);
+    w.w11 = _mm256_mul_ps(tx, ty);
+    return w;
+}
+
+// all-ones lanes where the flag bit is set
+__attribute__((target("avx2")))
+inline __m256 flagMask8(__m256i cellFlags, CellFlag flag) {
+    __m256i bit = _mm256_set1_epi32(flag);
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(cellFlags, bit), bit));
+}
+
+// scalar storage: 16 bit fields are widened to fp32 on load and rounded back on store,
+// with the same rounding as fromFloat()
+
+// low 16 bits of each 32 bit lane, in lane order
+__attribute__((target("avx2")))
+inline __m128i pack8(__m256i lanes) {
+    __m256i packed = _mm256_packus_epi32(lanes, lanes);
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(packed, 0x08));
+}
+
+__attribute__((target("avx2")))
+inline __m256 load8(const float* p) { return _mm256_loadu_ps(p); }
+
+__attribute__((target("avx2,f16c")))
+inline __m256 load8(const Half* p) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+__attribute__((target("avx2")))
+inline __m256 load8(const BFloat16* p) {
+    __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+}
+
+__attribute__((target("avx2")))
+inline void store8(float* p, __m256 value) { _mm256_storeu_ps(p, value); }
+
+__attribute__((target("avx2,f16c")))
+inline void store8(Half* p, __m256 value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+}
+
+__attribute__((target("avx2")))
+inline void store8(BFloat16* p, __m256 value) {
+    __m256i bits = _mm256_castps_si256(value);
+    __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    __m256i rounded = _mm256_add_epi32(bits, _mm256_add_epi32(_mm256_set1_epi32(0x7FFF), odd));
+    __m256i quiet = _mm256_or_si256(bits, _mm256_set1_epi32(0x400000));
+    __m256 nan = _mm256_cmp_ps(value, value, _CMP_UNORD_Q);
+    rounded = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(rounded), _mm256_castsi256_ps(quiet), nan));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), pack8(_mm256_srli_epi32(rounded, 16)));
+}
+
+__attribute__((target("avx2")))
+inline __m256 gather8(const float* field, __m256i index) { return _mm256_i32gather_ps(field, index, 4); }
+
+// 16 bit gathers load the 32 bits ending at each element; the element before a sample
+// is always inside the field, the one after may not be
+__attribute__((target("avx2")))
+inline __m256i gatherUpper8(const void* field, __m256i index) {
+    const int* base = reinterpret_cast<const int*>(static_cast<const char*>(field) - 2);
+    return _mm256_i32gather_epi32(base, index, 2);
+}
+
+__attribute__((target("avx2,f16c")))
+inline __m256 gather8(const Half* field, __m256i index) {
+    return _mm256_cvtph_ps(pack8(_mm256_srli_epi32(gatherUpper8(field, index), 16)));
+}
+
+__attribute__((target("avx2")))
+inline __m256 gather8(const BFloat16* field, __m256i index) {
+    __m256i upper = _mm256_and_si256(gatherUpper8(field, index), _mm256_set1_epi32(static_cast<int>(0xFFFF0000u)));
+    return _mm256_castsi256_ps(upper);
+}
+
+template <typename T>
+__attribute__((target("avx2,f16c")))
+inline __m256 interpolate8(const T* field, const Weights8& w) {
+    __m256 f00 = gather8(field, w.i00);
+    __m256 f10 = gather8(field, w.i10);
+    __m256 f11 = gather8(field, w.i11);
+    __m256 f01 = gather8(field, w.i01);
+    __m256 sum = _mm256_add_ps(_mm256_mul_ps(w.w00, f00), _mm256_mul_ps(w.w10, f10));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(w.w11, f11));
+    return _mm256_add_ps(sum, _mm256_mul_ps(w.w01, f01));
+}
+
+template <typename T, bool HasInk>
+__attribute__((target("avx2,f16c")))
+void advectRowAVX2(const AdvectionFields& f, int j, int iBegin, int iEnd) {
+    const int stride = f.stride;
+    const float* u = f.u;
+    const float* v = f.v;
+    const uint8_t* flags = f.flags;
+    int i = iBegin;
+
+    const T* scalars[MAX_PASSIVE_SCALARS];
+    T* scalarsNext[MAX_PASSIVE_SCALARS];
+    for (int n = 0; n < f.scalarCount; n++) {
+        scalars[n] = static_cast<const T*>(f.scalars[n]);
+        scalarsNext[n] = static_cast<T*>(f.scalarsNext[n]);
+    }
+
+    // the next row and column are in range for every cell thanks to the ghost layers;
+    // the faces on the far domain edge are masked like the scalar kernel skips them
+    if (i >= 1) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 h = _mm256_set1_ps(f.cellHeight);
+        const __m256 hh = _mm256_set1_ps(f.halfCellHeight);
+        const __m256 dt = _mm256_set1_ps(f.timeStep);
+        const __m256 two = _mm256_set1_ps(2.0f);
+        const __m256 four = _mm256_set1_ps(4.0f);
+        const __m256 yFace = _mm256_set1_ps(j * f.cellHeight);
+        const __m256 yCenter = _mm256_set1_ps(j * f.cellHeight + f.halfCellHeight);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i lastFaceX = _mm256_set1_epi32(f.gridX - 1);
+        const bool inkRow = HasInk && j >= f.inkSkipRowBegin && j < f.inkSkipRowEnd;
+        const bool faceRowU = j < f.gridY - 1;
+
+        for (; i + 8 <= iEnd; i += 8) {
+            int k = f.origin + j * stride + i;
+            __m256i iv = _mm256_add_epi32(_mm256_set1_epi32(i), lanes);
+            __m256 iF = _mm256_cvtepi32_ps(iv);
+
+            __m256i cellFlags = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags + k)));
+            __m256 fluid = flagMask8(cellFlags, CELL_FLUID);
+            __m256 uC = _mm256_loadu_ps(u + k);
+            __m256 vC = _mm256_loadu_ps(v + k);
+            __m256 uOut = uC;
+            __m256 vOut = vC;
+
+            if (_mm256_movemask_ps(fluid) != 0) {
+                // x vel advection
+                __m256 maskU = faceRowU ? flagMask8(cellFlags, CELL_XM) : zero;
+                if (_mm256_movemask_ps(maskU) != 0) {
+                    __m256 nY = _mm256_add_ps(_mm256_loadu_ps(v + k - 1), vC);
+                    nY = _mm256_add_ps(nY, _mm256_loadu_ps(v + k - 1 + stride));
+                    nY = _mm256_div_ps(_mm256_add_ps(nY, _mm256_loadu_ps(v + k + stride)), four);
+                    __m256 x0 = _mm256_sub_ps(_mm256_mul_ps(iF, h), _mm256_mul_ps(uC, dt));
+                    __m256 y0 = _mm256_sub_ps(yCenter, _mm256_mul_ps(nY, dt));
+                    __m256 sampled = interpolate8(u, weights8<Staggering::U_FACE>(f.sampler, x0, y0));
+                    uOut = _mm256_blendv_ps(uOut, sampled, maskU);
+                }
+
+                // y vel advection
+                __m256 maskV = _mm256_and_ps(flagMask8(cellFlags, CELL_YM),
+                                             _mm256_castsi256_ps(_mm256_cmpgt_epi32(lastFaceX, iv)));
+                if (_mm256_movemask_ps(maskV) != 0) {
+                    __m256 nX = _mm256_add_ps(_mm256_loadu_ps(u + k - stride), uC);
+                    nX = _mm256_add_ps(nX, _mm256_loadu_ps(u + k + 1 - stride));
+                    nX = _mm256_div_ps(_mm256_add_ps(nX, _mm256_loadu_ps(u + k + 1)), four);
+                    __m256 x0 = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(iF, h), hh), _mm256_mul_ps(nX, dt));
+                    __m256 y0 = _mm256_sub_ps(yFace, _mm256_mul_ps(vC, dt));
+                    __m256 sampled = interpolate8(v, weights8<Staggering::V_FACE>(f.sampler, x0, y0));
+                    vOut = _mm256_blendv_ps(vOut, sampled, maskV);
+                }
+            }
+
+            _mm256_storeu_ps(f.uNext + k, uOut);
+            _mm256_storeu_ps(f.vNext + k, vOut);
+
+            if (_mm256_movemask_ps(fluid) == 0) {
+                for (int n = 0; n < f.scalarCount; n++) {
+                    std::memcpy(scalarsNext[n] + k, scalars[n] + k, 8 * sizeof(T));
+                }
+                continue;
+            }
+
+            // smoke and ink advection
+            __m256 velX = _mm256_div_ps(_mm256_add_ps(uC, _mm256_loadu_ps(u + k + 1)), two);
+            __m256 velY = _mm256_div_ps(_mm256_add_ps(vC, _mm256_loadu_ps(v + k + stride)), two);
+            __m256 x1 = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(iF, h), hh), _mm256_mul_ps(velX, dt));
+            __m256 y1 = _mm256_sub_ps(yCenter, _mm256_mul_ps(velY, dt));
+            Weights8 weights = weights8<Staggering::CELL_CENTER>(f.sampler, x1, y1);
+
+            __m256 inkMask = zero;
+            if (HasInk) {
+                __m256 skipInk = inkRow ? _mm256_castsi256_ps(_mm256_cmpeq_epi32(iv, _mm256_set1_epi32(1))) : zero;
+                __m256 noInk = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (int n = 0; n < f.scalarCount; n++) {
+                    if (f.scalarIsInk[n]) {
+                        noInk = _mm256_and_ps(noInk, _mm256_cmp_ps(load8(scalars[n] + k), zero, _CMP_EQ_OQ));
+                    }
+                }
+                inkMask = _mm256_andnot_ps(_mm256_or_ps(skipInk, noInk), fluid);
+            }
+
+            for (int n = 0; n < f.scalarCount; n++) {
+                __m256 mask = HasInk && f.scalarIsInk[n] ? inkMask : fluid;
+                if (_mm256_movemask_ps(mask) == 0) {
+                    std::memcpy(scalarsNext[n] + k, scalars[n] + k, 8 * sizeof(T));
+                    continue;
+                }
+                __m256 current = _mm256_blendv_ps(load8(scalars[n] + k), interpolate8(scalars[n], weights), mask);
+                store8(scalarsNext[n] + k, current);
+            }
+        }
+    }
+
+    advectRowScalarT<float, T, HasInk>(f, j, i, iEnd);
+}
+
+// AVX-512: 16 cells per iteration
+
+// GCC 12's avx512fintrin.h reports its own undefined-register idiom (_mm512_undefined_*)
+// as '__Y may be used uninitialized' at every inlined intrinsic
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+struct Weights16 {
+    __m512i i00, i10, i01, i11;
+    __m512 w00, w10, w01, w11;
+};
+
+template <Staggering S>
+__attribute__((target("avx512f")))
+inline Weights16 weights16(const GridSampler& g, __m512 px, __m512 py) {
+    const __m512 h = _mm512_set1_ps(g.cellHeight);
+    const __m512 xOffset = _mm512_set1_ps(StaggerOffset<S>::x * g.cellHeight);
+    const __m512 yOffset = _mm512_set1_ps(StaggerOffset<S>::y * g.cellHeight);
+    const __m512i one = _mm512_set1_epi32(1);
+
+    px = _mm512_min_ps(_mm512_max_ps(px, h), _mm512_set1_ps(g.xHeight));
+    py = _mm512_min_ps(_mm512_max_ps(py, h), _mm512_set1_ps(g.yHeight));
+    __m512 rx = _mm512_sub_ps(px, xOffset);
+    __m512 ry = _mm512_sub_ps(py, yOffset);
+
+    // as in GridSampler::weights, x1/y1 may land in the high ghost layers
+    __m512i x0 = _mm512_cvttps_epi32(_mm512_div_ps(rx, h));
+    __m512i x1 = _mm512_add_epi32(x0, one);
+    __m512i y0 = _mm512_cvttps_epi32(_mm512_div_ps(ry, h));
+    __m512i y1 = _mm512_add_epi32(y0, one);
+
+    __m512 tx = _mm512_div_ps(_mm512_sub_ps(rx, _mm512_mul_ps(_mm512_cvtepi32_ps(x0), h)), h);
+    __m512 ty = _mm512_div_ps(_mm512_sub_ps(ry, _mm512_mul_ps(_mm512_cvtepi32_ps(y0), h)), h);
+    __m512 sx = _mm512_sub_ps(_mm512_set1_ps(1.0f), tx);
+    __m512 sy = _mm512_sub_ps(_mm512_set1_ps(1.0f), ty);
+
+    const __m512i stride = _mm512_set1_epi32(g.stride);
+    const __m512i origin = _mm512_set1_epi32(g.origin);
+    __m512i row0 = _mm512_add_epi32(_mm512_mullo_epi32(y0, stride), origin);
+    __m512i row1 = _mm512_add_epi32(_mm512_mullo_epi32(y1, stride), origin);
+
+    Weights16 w;
+    w.i00 = _mm512_add_epi32(row0, x0);
+    w.i10 = _mm512_add_epi32(row0, x1);
+    w.i01 = _mm512_add_epi32(row1, x0);
+    w.i11 = _mm512_add_epi32(row1, x1);
+    w.w00 = _mm512_mul_ps(sx, sy);
+    w.w10 = _mm512_mul_ps(tx, sy);
+    w.w01 = _mm512_mul_ps(sx, ty);
+    w.w11 = _mm512_mul_ps(tx, ty);
+    return w;
+}
+
+__attribute__((target("avx512f")))
+inline __m512 load16(const float* p) { return _mm512_loadu_ps(p); }
+
+__attribute__((target("avx512f")))
+inline __m512 load16(const Half* p) {
+    return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+
+__attribute__((target("avx512f")))
+inline __m512 load16(const BFloat16* p) {
+    __m512i wide = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(wide, 16));
+}
+
+__attribute__((target("avx512f")))
+inline void store16(float* p, __m512 value) { _mm512_storeu_ps(p, value); }
+
+__attribute__((target("avx512f")))
+inline void store16(Half* p, __m512 value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+}
+
+__attribute__((target("avx512f")))
+inline void store16(BFloat16* p, __m512 value) {
+    __m512i bits = _mm512_castps_si512(value);
+    __m512i odd = _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+    __m512i rounded = _mm512_add_epi32(bits, _mm512_add_epi32(_mm512_set1_epi32(0x7FFF), odd));
+    __mmask16 nan = _mm512_cmp_ps_mask(value, value, _CMP_UNORD_Q);
+    rounded = _mm512_mask_or_epi32(rounded, nan, bits, _mm512_set1_epi32(0x400000));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_cvtepi32_epi16(_mm512_srli_epi32(rounded, 16)));
+}
+
+__attribute__((target("avx512f")))
+inline __m512 gather16(const float* field, __m512i index) { return _mm512_i32gather_ps(index, field, 4); }
+
+// see gatherUpper8
+__attribute__((target("avx512f")))
+inline __m512i gatherUpper16(const void* field, __m512i index) {
+    return _mm512_i32gather_epi32(index, static_cast<const char*>(field) - 2, 2);
+}
+
+__attribute__((target("avx512f")))
+inline __m512 gather16(const Half* field, __m512i index) {
+    return _mm512_cvtph_ps(_mm512_cvtepi32_epi16(_mm512_srli_epi32(gatherUpper16(field, index), 16)));
+}
+
+__attribute__((target("avx512f")))
+inline __m512 gather16(const BFloat16* field, __m512i index) {
+    __m512i upper = _mm512_and_si512(gatherUpper16(field, index), _mm512_set1_epi32(static_cast<int>(0xFFFF0000u)));
+    return _mm512_castsi512_ps(upper);
+}
+
+template <typename T>
+__attribute__((target("avx512f")))
+inline __m512 interpolate16(const T* field, const Weights16& w) {
+    __m512 f00 = gather16(field, w.i00);
+    __m512 f10 = gather16(field, w.i10);
+    __m512 f11 = gather16(field, w.i11);
+    __m512 f01 = gather16(field, w.i01);
+    __m512 sum = _mm512_add_ps(_mm512_mul_ps(w.w00, f00), _mm512_mul_ps(w.w10, f10));
+    sum = _mm512_add_ps(sum, _mm512_mul_ps(w.w11, f11));
+    return _mm512_add_ps(sum, _mm512_mul_ps(w.w01, f01));
+}
+
+template <typename T, bool HasInk>
+__attribute__((target("avx512f")))
+void advectRowAVX512(const AdvectionFields& f, int j, int iBegin, int iEnd) {
+    const int stride = f.stride;
+    const float* u = f.u;
+    const float* v = f.v;
+    const uint8_t* flags = f.flags;
+    int i = iBegin;
+
+    const T* scalars[MAX_PASSIVE_SCALARS];
+    T* scalarsNext[MAX_PASSIVE_SCALARS];
+    for (int n = 0; n < f.scalarCount; n++) {
+        scalars[n] = static_cast<const T*>(f.scalars[n]);
+        scalarsNext[n] = static_cast<T*>(f.scalarsNext[n]);
+    }
+
+    // the next row and column are in range for every cell thanks to the ghost layers;
+    // the faces on the far domain edge are masked like the scalar kernel skips them
+    if (i >= 1) {
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512 h = _mm512_set1_ps(f.cellHeight);
+        const __m512 hh = _mm512_set1_ps(f.halfCellHeight);
+        const __m512 dt = _mm512_set1_ps(f.timeStep);
+        const __m512 two = _mm512_set1_ps(2.0f);
+        const __m512 four = _mm512_set1_ps(4.0f);
+        const __m512 yFace = _mm512_set1_ps(j * f.cellHeight);
+        const __m512 yCenter = _mm512_set1_ps(j * f.cellHeight + f.halfCellHeight);
+        const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        const __m512i lastFaceX = _mm512_set1_epi32(f.gridX - 1);
+        const bool inkRow = HasInk && j >= f.inkSkipRowBegin && j < f.inkSkipRowEnd;
+        const bool faceRowU = j < f.gridY - 1;
+
+        for (; i + 16 <= iEnd; i += 16) {
+            int k = f.origin + j * stride + i;
+            __m512i iv = _mm512_add_epi32(_mm512_set1_epi32(i), lanes);
+            __m512 iF = _mm512_cvtepi32_ps(iv);
+
+            __m512i cellFlags = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + k)));
+            __mmask16 fluid = _mm512_test_epi32_mask(cellFlags, _mm512_set1_epi32(CELL_FLUID));
+            __m512 uC = _mm512_loadu_ps(u + k);
+            __m512 vC = _mm512_loadu_ps(v + k);
+            __m512 uOut = uC;
+            __m512 vOut = vC;
+
+            // x vel advection
+            __mmask16 maskU = faceRowU ? _mm512_test_epi32_mask(cellFlags, _mm512_set1_epi32(CELL_XM)) : 0;
+            if (maskU != 0) {
+                __m512 nY = _mm512_add_ps(_mm512_loadu_ps(v + k - 1), vC);
+                nY = _mm512_add_ps(nY, _mm512_loadu_ps(v + k - 1 + stride));
+                nY = _mm512_div_ps(_mm512_add_ps(nY, _mm512_loadu_ps(v + k + stride)), four);
+                __m512 x0 = _mm512_sub_ps(_mm512_mul_ps(iF, h), _mm512_mul_ps(uC, dt));
+                __m512 y0 = _mm512_sub_ps(yCenter, _mm512_mul_ps(nY, dt));
+                __m512 sampled = interpolate16(u, weights16<Staggering::U_FACE>(f.sampler, x0, y0));
+                uOut = _mm512_mask_blend_ps(maskU, uOut, sampled);
+            }
+
+            // y vel advection
+            __mmask16 maskV = _mm512_mask_test_epi32_mask(_mm512_cmplt_epi32_mask(iv, lastFaceX),
+                                                          cellFlags, _mm512_set1_epi32(CELL_YM));
+            if (maskV != 0) {
+                __m512 nX = _mm512_add_ps(_mm512_loadu_ps(u + k - stride), uC);
+                nX = _mm512_add_ps(nX, _mm512_loadu_ps(u + k + 1 - stride));
+                nX = _mm512_div_ps(_mm512_add_ps(nX, _mm512_loadu_ps(u + k + 1)), four);
+                __m512 x0 = _mm512_sub_ps(_mm512_add_ps(_mm512_mul_ps(iF, h), hh), _mm512_mul_ps(nX, dt));
+                __m512 y0 = _mm512_sub_ps(yFace, _mm512_mul_ps(vC, dt));
+                __m512 sampled = interpolate16(v, weights16<Staggering::V_FACE>(f.sampler, x0, y0));
+                vOut = _mm512_mask_blend_ps(maskV, vOut, sampled);
+            }
+
+            _mm512_storeu_ps(f.uNext + k, uOut);
+            _mm512_storeu_ps(f.vNext + k, vOut);
+
+            if (fluid == 0) {
+                for (int n = 0; n < f.scalarCount; n++) {
+                    std::memcpy(scalarsNext[n] + k, scalars[n] + k, 16 * sizeof(T));
+                }
+                continue;
+            }
+
+            // smoke and ink advection
+            __m512 velX = _mm512_div_ps(_mm512_add_ps(uC, _mm512_loadu_ps(u + k + 1)), two);
+            __m512 velY = _mm512_div_ps(_mm512_add_ps(vC, _mm512_loadu_ps(v + k + stride)), two);
+            __m512 x1 = _mm512_sub_ps(_mm512_add_ps(_mm512_mul_ps(iF, h), hh), _mm512_mul_ps(velX, dt));
+            __m512 y1 = _mm512_sub_ps(yCenter, _mm512_mul_ps(velY, dt));
+            Weights16 weights = weights16<Staggering::CELL_CENTER>(f.sampler, x1, y1);
+
+            __mmask16 inkMask = 0;
+            if (HasInk) {
+                __mmask16 skipInk = inkRow ? _mm512_cmpeq_epi32_mask(iv, _mm512_set1_epi32(1)) : 0;
+                __mmask16 noInk = 0xFFFF;
+                for (int n = 0; n < f.scalarCount; n++) {
+                    if (f.scalarIsInk[n]) {
+                        noInk &= _mm512_cmp_ps_mask(load16(scalars[n] + k), zero, _CMP_EQ_OQ);
+                    }
+                }
+                inkMask = fluid & ~(skipInk | noInk);
+            }
+
+            for (int n = 0; n < f.scalarCount; n++) {
+                __mmask16 mask = HasInk && f.scalarIsInk[n] ? inkMask : fluid;
+                if (mask == 0) {
+                    std::memcpy(scalarsNext[n] + k, scalars[n] + k, 16 * sizeof(T));
+                    continue;
+                }
+                __m512 current = _mm512_mask_blend_ps(mask, load16(scalars[n] + k), interpolate16(scalars[n], weights));
+                store16(scalarsNext[n] + k, current);
+            }
+        }
+    }
+
+    advectRowScalarT<float, T, HasInk>(f, j, i, iEnd);
+}
+
+#pragma GCC diagnostic pop
+
+} // namespace
+#endif
+
+template <typename T, bool HasInk>
+AdvectRowKernel selectAdvectRowKernelT(SimdLevel requested, SimdLevel& selected) {
+#ifdef KATARA_X86_SIMD
+    __builtin_cpu_init();
+    bool allowAVX512 = requested == SimdLevel::AUTO || requested == SimdLevel::AVX512;
+    bool allowAVX2 = allowAVX512 || requested == SimdLevel::AVX2;
+
+    if (allowAVX512 && __builtin_cpu_supports("avx512f")) {
+        selected = SimdLevel::AVX512;
+        return advectRowAVX512<T, HasInk>;
+    }
+    if (allowAVX2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+        selected = SimdLevel::AVX2;
+        return advectRowAVX2<T, HasInk>;
+    }
+#endif
+    selected = SimdLevel::SCALAR;
+    return advectRowScalarT<float, T, HasInk>;
+}
+
+template <typename T>
+AdvectRowKernel selectAdvectRowKernelT(SimdLevel requested, bool ink, SimdLevel& selected) {
+    return ink ? selectAdvectRowKernelT<T, true>(requested, selected)
+               : selectAdvectRowKernelT<T, false>(requested, selected);
+}
+
+template <typename Real, typename T>
+BasicAdvectRowKernel<Real> scalarKernel(bool ink) {
+    return ink ? advectRowScalarT<Real, T, true> : advectRowScalarT<Real, T, false>;
+}
+
+template <>
+AdvectRowKernel selectAdvectRowKernel<float>(SimdLevel requested, ScalarPrecision precision, bool ink,
+                                             SimdLevel& selected) {
+    switch (precision) {
+        case ScalarPrecision::FP16: return selectAdvectRowKernelT<Half>(requested, ink, selected);
+        case ScalarPrecision::BF16: return selectAdvectRowKernelT<BFloat16>(requested, ink, selected);
+        default: return selectAdvectRowKernelT<float>(requested, ink, selected);
+    }
+}
+
+template <>
+BasicAdvectRowKernel<double> selectAdvectRowKernel<double>(SimdLevel, ScalarPrecision precision, bool ink,
+                                                           SimdLevel& selected) {
+    selected = SimdLevel::SCALAR;
+    switch (precision) {
+        case ScalarPrecision::FP16: return scalarKernel<double, Half>(ink);
+        case ScalarPrecision::BF16: return scalarKernel<double, BFloat16>(ink);
+        default: return scalarKernel<double, float>(ink);
+    }
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SCALAR: return "scalar";
+        default: return "auto";
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef ADVECT_KERNELS_H
+#define ADVECT_KERNELS_H
+
+#include "sampler.h"
+#include "config.h"
+#include "cell_flags.h"
+
+static const int MAX_PASSIVE_SCALARS = 8;
+
+// everything the semi-Lagrangian advection kernels read and write for one step; Real
+// is the simulator's scalar type
+template <typename Real>
+struct BasicAdvectionFields {
+    int gridX, gridY;
+    int stride, origin; // GridLayout addressing, ghost layers filled
+    Real cellHeight, halfCellHeight;
+    Real timeStep;
+    BasicGridSampler<Real> sampler;
+
+    const uint8_t* flags; // stencil flags
+    const Real* u; // x velocity
+    const Real* v; // y velocity
+    Real* uNext;
+    Real* vNext;
+
+    // passive scalars sharing one cell-center backtrace, all stored in scalarPrecision
+    // (float, Half or BFloat16 elements) and interpolated in Real
+    ScalarPrecision scalarPrecision;
+    int scalarCount;
+    const void* scalars[MAX_PASSIVE_SCALARS];
+    void* scalarsNext[MAX_PASSIVE_SCALARS];
+    bool scalarIsInk[MAX_PASSIVE_SCALARS];
+
+    // ink is not advected in the wind tunnel column or in cells without ink
+    int inkSkipRowBegin, inkSkipRowEnd;
+};
+
+typedef BasicAdvectionFields<float> AdvectionFields;
+
+// advects cells [iBegin, iEnd) of row j; every visited cell is written, either with
+// its advected value or carried over from the current field
+template <typename Real>
+using BasicAdvectRowKernel = void (*)(const BasicAdvectionFields<Real>& fields, int j, int iBegin, int iEnd);
+typedef BasicAdvectRowKernel<float> AdvectRowKernel;
+
+// widest kernel the CPU supports for the scalar storage precision, capped at the requested
+// level; the vector kernels are float only, double always runs the scalar kernel. every
+// kernel is compiled twice, and ink = false picks the variant without the ink masking
+// for runs where no passive scalar is ink. instantiated for float and double
+template <typename Real>
+BasicAdvectRowKernel<Real> selectAdvectRowKernel(SimdLevel requested, ScalarPrecision precision, bool ink,
+                                                 SimdLevel& selected);
+template <typename Real>
+void advectRowScalar(const BasicAdvectionFields<Real>& fields, int j, int iBegin, int iEnd);
+const char* simdLevelName(SimdLevel level);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef CELL_FLAGS_H
+#define CELL_FLAGS_H
+
+#include <cstdint>
+#include "grid_layout.h"
+#include "grid_traversal.h"
+
+// one byte per cell encoding the 5-point stencil; rebuilt only when obstacles change.
+// neighbor bits are only set on fluid cells, so a neighbor bit also means the shared
+// face is open (both cells fluid)
+enum CellFlag : uint8_t {
+    CELL_FLUID = 1 << 0,
+    CELL_XP = 1 << 1, // i+1 neighbor is fluid
+    CELL_XM = 1 << 2, // i-1 neighbor is fluid
+    CELL_YP = 1 << 3, // j+1 neighbor is fluid
+    CELL_YM = 1 << 4  // j-1 neighbor is fluid
+};
+
+// stencil coefficient (0 or 1) of one neighbor
+inline float cellCoeff(uint8_t flags, CellFlag neighbor) {
+    return (flags & neighbor) ? 1.0f : 0.0f;
+}
+
+// number of fluid neighbors of a fluid cell, 0 for solid cells (Laplacian diagonal)
+inline float cellValence(uint8_t flags) {
+    return static_cast<float>(((flags >> 1) & 1) + ((flags >> 2) & 1) + ((flags >> 3) & 1) + ((flags >> 4) & 1));
+}
+
+// flags of the cells in range from a solid field (0 = solid) in the given layout; the
+// ghost cells of s must be solid, which makes every neighbor read in range and removes
+// the bounds checks. a change of s at one cell changes the flags of its four neighbors
+// too, so a range rebuilt after an edit must reach one cell past it
+template <typename Real>
+inline void buildCellFlags(const Real* s, const GridLayout& layout, uint8_t* flags, const CellRange& range) {
+    const int stride = layout.stride;
+    #pragma omp parallel for
+    for (int j = range.jBegin; j < range.jEnd; j++) {
+        for (int i = range.iBegin; i < range.iEnd; i++) {
+            int k = layout.idx(i, j);
+            if (s[k] == 0.0f) {
+                flags[k] = 0;
+                continue;
+            }
+            uint8_t f = CELL_FLUID;
+            if (s[k + 1] != 0.0f) f |= CELL_XP;
+            if (s[k - 1] != 0.0f) f |= CELL_XM;
+            if (s[k + stride] != 0.0f) f |= CELL_YP;
+            if (s[k - stride] != 0.0f) f |= CELL_YM;
+            flags[k] = f;
+        }
+    }
+}
+
+template <typename Real>
+inline void buildCellFlags(const Real* s, const GridLayout& layout, uint8_t* flags) {
+    buildCellFlags(s, layout, flags, {0, layout.gridX, 0, layout.gridY});
+}
+
+#endif
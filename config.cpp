@@ -33,6 +33,12 @@ Config ConfigLoader::loadConfig(const std::string& filename) {
     if (j.contains("ink")) {
         config.ink = loadInkConfig(j["ink"]);
     }
+    if (j.contains("pacing")) {
+        config.pacing = loadPacingConfig(j["pacing"]);
+    }
+    if (j.contains("profiling")) {
+        config.profiling = loadProfilingConfig(j["profiling"]);
+    }
 
     return config;
 }
@@ -48,6 +54,55 @@ PipelineType ConfigLoader::stringToPipelineType(const std::string& type) {
     return PipelineType::CPU;
 }
 
+ProjectionSolver ConfigLoader::stringToProjectionSolver(const std::string& solver) {
+    if (solver == "gauss-seidel") {
+        return ProjectionSolver::GAUSS_SEIDEL;
+    } else if (solver == "red-black") {
+        return ProjectionSolver::RED_BLACK;
+    } else if (solver == "pcg") {
+        return ProjectionSolver::PCG;
+    } else if (solver == "multigrid") {
+        return ProjectionSolver::MULTIGRID;
+    }
+    return ProjectionSolver::GAUSS_SEIDEL;
+}
+
+RealType ConfigLoader::stringToRealType(const std::string& type) {
+    if (type == "double") {
+        return RealType::DOUBLE;
+    }
+    return RealType::FLOAT;
+}
+
+SimdLevel ConfigLoader::stringToSimdLevel(const std::string& level) {
+    if (level == "scalar") {
+        return SimdLevel::SCALAR;
+    } else if (level == "avx2") {
+        return SimdLevel::AVX2;
+    } else if (level == "avx512") {
+        return SimdLevel::AVX512;
+    }
+    return SimdLevel::AUTO;
+}
+
+ScalarPrecision ConfigLoader::stringToScalarPrecision(const std::string& precision) {
+    if (precision == "fp16") {
+        return ScalarPrecision::FP16;
+    } else if (precision == "bf16") {
+        return ScalarPrecision::BF16;
+    }
+    return ScalarPrecision::FP32;
+}
+
+PacingMode ConfigLoader::stringToPacingMode(const std::string& mode) {
+    if (mode == "vsync") {
+        return PacingMode::VSYNC;
+    } else if (mode == "uncapped") {
+        return PacingMode::UNCAPPED;
+    }
+    return PacingMode::FIXED;
+}
+
 WindowConfig ConfigLoader::loadWindowConfig(const json& j) {
     WindowConfig config;
     config.baseSize = j.value("baseSize", 800);
@@ -62,7 +117,18 @@ SimulationConfig ConfigLoader::loadSimulationConfig(const json& j) {
     config.timestep = j.value("timestep", 1.0f / 60.0f);
     config.gravity = j.value("gravity", 0.0f);
     config.fluidDensity = j.value("fluidDensity", 1000.0f);
-
+    config.realType = stringToRealType(j.value("realType", "float"));
+    config.simd = stringToSimdLevel(j.value("simd", "auto"));
+    config.hugePages = j.value("hugePages", true);
+    config.scalarPrecision = stringToScalarPrecision(j.value("scalarPrecision", "fp32"));
+    config.threaded = j.value("threaded", false);
+
+    if (j.contains("traversal")) {
+        config.traversal = loadTraversalConfig(j["traversal"]);
+    }
+    if (j.contains("activity")) {
+        config.activity = loadActivityConfig(j["activity"]);
+    }
     if (j.contains("projection")) {
         config.projection = loadProjectionConfig(j["projection"]);
     }
@@ -72,6 +138,11 @@ SimulationConfig ConfigLoader::loadSimulationConfig(const json& j) {
     if (j.contains("windTunnel")) {
         config.windTunnel = loadWindTunnelConfig(j["windTunnel"]);
     }
+    if (j.contains("boundaries")) {
+        for (const json& boundary : j["boundaries"]) {
+            config.boundaries.push_back(loadBoundaryConfig(boundary));
+        }
+    }
     if (j.contains("circle")) {
         config.circle = loadCircleConfig(j["circle"]);
     }
@@ -94,10 +165,49 @@ InkConfig ConfigLoader::loadInkConfig(const json& j) {
     return config;
 }
 
+PacingConfig ConfigLoader::loadPacingConfig(const json& j) {
+    PacingConfig config;
+    config.mode = stringToPacingMode(j.value("mode", "fixed"));
+    config.targetFps = j.value("targetFps", 60.0f);
+    config.maxStepsPerFrame = j.value("maxStepsPerFrame", 1);
+    config.reportInterval = j.value("reportInterval", 0);
+    return config;
+}
+
+ProfilingConfig ConfigLoader::loadProfilingConfig(const json& j) {
+    ProfilingConfig config;
+    config.enabled = j.value("enabled", true);
+    config.reportInterval = j.value("reportInterval", 0);
+    return config;
+}
+
+TraversalConfig ConfigLoader::loadTraversalConfig(const json& j) {
+    TraversalConfig config;
+    config.tileRows = j.value("tileRows", 8);
+    config.tileCols = j.value("tileCols", 0);
+    return config;
+}
+
+ActivityConfig ConfigLoader::loadActivityConfig(const json& j) {
+    ActivityConfig config;
+    config.enabled = j.value("enabled", false);
+    config.tileSize = j.value("tileSize", 16);
+    config.tolerance = j.value("tolerance", 1e-5f);
+    return config;
+}
+
 ProjectionConfig ConfigLoader::loadProjectionConfig(const json& j) {
     ProjectionConfig config;
+    config.solver = stringToProjectionSolver(j.value("solver", "gauss-seidel"));
     config.overrelaxationCoefficient = j.value("overrelaxationCoefficient", 1.9f);
     config.iterations = j.value("iterations", 40);
+    config.tolerance = j.value("tolerance", 1e-4f);
+    config.maxIterations = j.value("maxIterations", 200);
+    config.warmStart = j.value("warmStart", false);
+    config.earlyExit = j.value("earlyExit", false);
+    config.multigridCycle = j.value("multigridCycle", 1);
+    config.smoothingIterations = j.value("smoothingIterations", 2);
+    config.blockDepth = j.value("blockDepth", 1);
     return config;
 }
 
@@ -118,6 +228,16 @@ WindTunnelConfig ConfigLoader::loadWindTunnelConfig(const json& j) {
     return config;
 }
 
+BoundaryConfig ConfigLoader::loadBoundaryConfig(const json& j) {
+    BoundaryConfig config;
+    config.type = j.value("type", "inflow") == "outflow" ? BoundaryType::OUTFLOW : BoundaryType::INFLOW;
+    config.side = j.value("side", 0);
+    config.startPosition = j.value("startPosition", 0.45f);
+    config.endPosition = j.value("endPosition", 0.55f);
+    config.velocity = j.value("velocity", 1.5f);
+    return config;
+}
+
 CircleConfig ConfigLoader::loadCircleConfig(const json& j) {
     CircleConfig config;
     config.radius = j.value("radius", 10);
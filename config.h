@@ -2,7 +2,9 @@
 #define CONFIG_H
 
 #include <string>
+#include <vector>
 #include "json.hpp"
+#include "scalar_storage.h"
 
 using json = nlohmann::json;
 
@@ -12,9 +14,52 @@ struct WindowConfig {
     int defaultHeight = 800;
 };
 
+enum class ProjectionSolver {
+    GAUSS_SEIDEL,
+    RED_BLACK,
+    PCG,
+    MULTIGRID
+};
+
+enum class SimdLevel {
+    AUTO,
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+enum class RealType {
+    FLOAT,
+    DOUBLE
+};
+
 struct ProjectionConfig {
+    ProjectionSolver solver = ProjectionSolver::GAUSS_SEIDEL;
     float overrelaxationCoefficient = 1.9f;
-    int iterations = 40;
+    int iterations = 40; // SOR sweeps
+    float tolerance = 1e-4f; // max cell divergence for tolerance-based solvers
+    int maxIterations = 200; // cap for PCG iterations, multigrid cycles and early-exit SOR sweeps
+    bool warmStart = false; // start from the previous step's pressure
+    bool earlyExit = false; // SOR: stop once the residual is below tolerance
+    int multigridCycle = 1; // 1=V-cycle, 2=W-cycle
+    int smoothingIterations = 2; // red-black sweeps before and after each coarse correction
+    // SOR sweeps run as one cache-blocked wavefront; 1 = one grid sweep at a time. above 1
+    // the flat row parallelism of a sweep becomes a pipeline of traversal tiles (rows of a
+    // tile run serially), so it only pays off on grids that spill the cache
+    int blockDepth = 1;
+};
+
+struct TraversalConfig {
+    int tileRows = 8; // rows per tile handed to one thread
+    int tileCols = 0; // cells per tile row; 0 = whole rows
+};
+
+// skips advection and vorticity in tiles where the step could change no value by more
+// than tolerance; tiles are re-checked every step
+struct ActivityConfig {
+    bool enabled = false;
+    int tileSize = 16; // cells per tile side
+    float tolerance = 1e-5f; // largest change per step a skipped cell may miss
 };
 
 struct VorticityConfig {
@@ -30,6 +75,20 @@ struct WindTunnelConfig {
     float velocity = 1.5f;
 };
 
+enum class BoundaryType {
+    INFLOW, // faces held at velocity, inlet cells kept free of smoke
+    OUTFLOW // open edge cells held at zero pressure
+};
+
+// an opening in one side of the domain
+struct BoundaryConfig {
+    BoundaryType type = BoundaryType::INFLOW;
+    int side = 0; // 0=left, 1=top, 2=bottom, 3=right
+    float startPosition = 0.45f; // 0-1 along the side
+    float endPosition = 0.55f;
+    float velocity = 1.5f; // into the domain; unused by outflows
+};
+
 struct CircleConfig {
     int radius = 10;
     float momentumTransferCoeff = 0.25f;
@@ -47,19 +106,47 @@ struct SimulationConfig {
     float timestep = 1.0f / 60.0f;
     float gravity = 0.0f;
     float fluidDensity = 1000.0f;
+    RealType realType = RealType::FLOAT; // scalar type of the CPU simulator; double for validation runs
+    SimdLevel simd = SimdLevel::AUTO; // widest advection kernel allowed; AUTO = best supported
+    bool hugePages = true; // transparent huge pages for the field arena once it spans one (Linux)
+    ScalarPrecision scalarPrecision = ScalarPrecision::FP32; // storage of density and ink
+    bool threaded = false; // app: step on a dedicated thread, rendering the latest completed step
+    TraversalConfig traversal;
+    ActivityConfig activity;
     ProjectionConfig projection;
     VorticityConfig vorticity;
     WindTunnelConfig windTunnel;
+    std::vector<BoundaryConfig> boundaries; // openings besides the wind tunnel
     CircleConfig circle;
 };
 
 struct RenderingConfig {
-    int target = 2; // 0=pressure, 1=smoke, 2=both, 3=ink
+    int target = 2; // 0=pressure, 1=smoke, 2=both, 3=ink, 4=vorticity
     bool showVelocityVectors = false;
     bool disableHistograms = false;
     float velocityScale = 0.05f;
 };
 
+enum class PacingMode {
+    FIXED, // sleep until the next frame at targetFps
+    VSYNC, // presentation waits for the display
+    UNCAPPED // no waiting, one simulation step per frame (benchmarking)
+};
+
+struct PacingConfig {
+    PacingMode mode = PacingMode::FIXED;
+    float targetFps = 60.0f; // FIXED paces to it, VSYNC counts dropped frames against it
+    int maxStepsPerFrame = 1; // accumulator cap; simulation time beyond it is dropped. above 1
+                              // only helps when a step costs well under a frame, or slow steps
+                              // multiply the frame time
+    int reportInterval = 0; // seconds between step/frame rate reports on stdout; 0 = never
+};
+
+struct ProfilingConfig {
+    bool enabled = true; // per-stage timers (compiled out without KATARA_PROFILING)
+    int reportInterval = 0; // frames between stage reports on stdout; 0 = never
+};
+
 struct InkConfig {
     std::string imagePath = "";
 };
@@ -70,6 +157,8 @@ struct Config {
     SimulationConfig simulation;
     RenderingConfig rendering;
     InkConfig ink;
+    PacingConfig pacing;
+    ProfilingConfig profiling;
 };
 
 class ConfigLoader {
@@ -78,13 +167,23 @@ public:
 
 private:
     static PipelineType stringToPipelineType(const std::string& type);
+    static ProjectionSolver stringToProjectionSolver(const std::string& solver);
+    static RealType stringToRealType(const std::string& type);
+    static SimdLevel stringToSimdLevel(const std::string& level);
+    static ScalarPrecision stringToScalarPrecision(const std::string& precision);
+    static PacingMode stringToPacingMode(const std::string& mode);
     static WindowConfig loadWindowConfig(const json& j);
     static SimulationConfig loadSimulationConfig(const json& j);
     static RenderingConfig loadRenderingConfig(const json& j);
     static InkConfig loadInkConfig(const json& j);
+    static PacingConfig loadPacingConfig(const json& j);
+    static ProfilingConfig loadProfilingConfig(const json& j);
+    static TraversalConfig loadTraversalConfig(const json& j);
+    static ActivityConfig loadActivityConfig(const json& j);
     static ProjectionConfig loadProjectionConfig(const json& j);
     static VorticityConfig loadVorticityConfig(const json& j);
     static WindTunnelConfig loadWindTunnelConfig(const json& j);
+    static BoundaryConfig loadBoundaryConfig(const json& j);
     static CircleConfig loadCircleConfig(const json& j);
 };
 
@@ -0,0 +1,87 @@
+#include "field_arena.h"
+#include <cstring>
+#include <new>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+static size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+FieldArena::FieldArena()
+    : base(nullptr),
+      bytes(0),
+      alignment(CACHE_LINE_BYTES),
+      elementCount(0),
+      hugePages(false)
+{
+}
+
+FieldArena::~FieldArena() {
+    clear();
+}
+
+void FieldArena::clear() {
+    if (base) {
+        ::operator delete(base, std::align_val_t(alignment));
+    }
+    base = nullptr;
+    bytes = 0;
+    elementCount = 0;
+    hugePages = false;
+    fields.clear();
+}
+
+FieldHandle FieldArena::addField(const char* name, size_t elementBytes) {
+    fields.push_back({name, elementBytes, ScalarPrecision::FP32, 0});
+    return static_cast<FieldHandle>(fields.size() - 1);
+}
+
+FieldHandle FieldArena::addScalarField(const char* name, ScalarPrecision precision) {
+    fields.push_back({name, scalarPrecisionBytes(precision), precision, 0});
+    return static_cast<FieldHandle>(fields.size() - 1);
+}
+
+void FieldArena::allocate(size_t elementCount, bool hugePages) {
+    if (base) {
+        ::operator delete(base, std::align_val_t(alignment));
+        base = nullptr;
+    }
+
+    size_t offset = 0;
+    for (Field& field : fields) {
+        field.offset = offset;
+        offset = roundUp(offset + field.elementBytes * elementCount, CACHE_LINE_BYTES);
+    }
+
+    // huge pages only pay off once the arena spans more than one of them
+    this->hugePages = hugePages && offset >= HUGE_PAGE_BYTES;
+    alignment = this->hugePages ? HUGE_PAGE_BYTES : CACHE_LINE_BYTES;
+    bytes = roundUp(offset, alignment);
+    this->elementCount = elementCount;
+    if (bytes == 0) return;
+
+    base = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(alignment)));
+#ifdef __linux__
+    // a hint; without THP support the arena just uses regular pages
+    if (this->hugePages) {
+        madvise(base, bytes, MADV_HUGEPAGE);
+    }
+#endif
+    // first touch after madvise, so the pages are faulted in as huge pages
+    std::memset(base, 0, bytes);
+}
+
+void FieldArena::swap(FieldHandle a, FieldHandle b) {
+    std::swap(fields[a].offset, fields[b].offset);
+}
+
+FieldHandle FieldArena::find(const std::string& name) const {
+    for (size_t n = 0; n < fields.size(); n++) {
+        if (fields[n].name == name) return static_cast<FieldHandle>(n);
+    }
+    return INVALID_FIELD;
+}
@@ -0,0 +1,102 @@
+#ifndef FIELD_ARENA_H
+#define FIELD_ARENA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "scalar_storage.h"
+
+// read-only view of one field, handed out to renderers instead of the storage itself.
+// density and ink may be stored in 16 bits (see scalar_storage.h); operator[] converts,
+// data() is the raw storage for uploads
+class FieldView {
+public:
+    FieldView() : ptr(nullptr), count(0), format(ScalarPrecision::FP32) {}
+    FieldView(const void* data, size_t size, ScalarPrecision precision = ScalarPrecision::FP32)
+        : ptr(data), count(size), format(precision) {}
+
+    const void* data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    ScalarPrecision precision() const { return format; }
+    size_t elementBytes() const { return scalarPrecisionBytes(format); }
+    float operator[](size_t i) const {
+        switch (format) {
+            case ScalarPrecision::FP16: return toFloat(static_cast<const Half*>(ptr)[i]);
+            case ScalarPrecision::BF16: return toFloat(static_cast<const BFloat16*>(ptr)[i]);
+            default: return static_cast<const float*>(ptr)[i];
+        }
+    }
+
+private:
+    const void* ptr;
+    size_t count;
+    ScalarPrecision format;
+};
+
+typedef int FieldHandle;
+static const FieldHandle INVALID_FIELD = -1;
+
+// every simulation field in one zeroed, aligned allocation. fields are registered by
+// name, then allocated together; each one starts on a cache line, and arenas of at
+// least one huge page are huge page aligned and can ask the OS for transparent huge pages
+class FieldArena {
+public:
+    static constexpr size_t CACHE_LINE_BYTES = 64;
+    static constexpr size_t HUGE_PAGE_BYTES = 2 << 20;
+
+    FieldArena();
+    ~FieldArena();
+    FieldArena(const FieldArena&) = delete;
+    FieldArena& operator=(const FieldArena&) = delete;
+
+    // frees the memory and forgets all fields
+    void clear();
+
+    // registers a field; must be called before allocate()
+    FieldHandle addField(const char* name, size_t elementBytes = sizeof(float));
+    // registers a density/ink field stored in the given precision
+    FieldHandle addScalarField(const char* name, ScalarPrecision precision);
+
+    // allocates elementCount elements for every registered field
+    void allocate(size_t elementCount, bool hugePages);
+
+    template <typename T = float>
+    T* get(FieldHandle field) const { return reinterpret_cast<T*>(base + fields[field].offset); }
+    // empty for fields a FieldView can't read: double fields (narrow them first, like
+    // realView() in sim.h) and the byte-sized cell flags
+    FieldView view(FieldHandle field) const {
+        if (field == INVALID_FIELD || fields[field].elementBytes != scalarPrecisionBytes(fields[field].precision)) {
+            return FieldView();
+        }
+        return FieldView(base + fields[field].offset, elementCount, fields[field].precision);
+    }
+
+    // exchanges the storage of two fields with the same element size (ping-pong buffers)
+    void swap(FieldHandle a, FieldHandle b);
+
+    FieldHandle find(const std::string& name) const;
+    int getFieldCount() const { return static_cast<int>(fields.size()); }
+    const std::string& getFieldName(FieldHandle field) const { return fields[field].name; }
+    size_t getElementBytes(FieldHandle field) const { return fields[field].elementBytes; }
+    size_t getElementCount() const { return elementCount; }
+    size_t getFootprintBytes() const { return bytes; }
+    bool usesHugePages() const { return hugePages; }
+
+private:
+    struct Field {
+        std::string name;
+        size_t elementBytes;
+        ScalarPrecision precision; // format of views; only fields of that size get one
+        size_t offset; // bytes from base
+    };
+    std::vector<Field> fields;
+
+    unsigned char* base;
+    size_t bytes;
+    size_t alignment;
+    size_t elementCount;
+    bool hugePages; // huge pages were requested for the current allocation
+};
+
+#endif
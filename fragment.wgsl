@@ -128,6 +128,9 @@ fn sampleFluidField(coord: vec2<f32>) -> vec4<f32> {
         } else if (uniforms.drawTarget == 3) {
             // draw ink diffusion
             color = mapInkToColor(redInk.r, greenInk.r, blueInk.r);
+        } else if (uniforms.drawTarget == 4) {
+            // draw vorticity (curl uploaded into the pressure texture)
+            color = mapValueToColor(pressure.r, uniforms.pressureMin, uniforms.pressureMax);
         } else {
             // draw pretty pressure + smoke
             color = mapValueToColor(pressure.r, uniforms.pressureMin, uniforms.pressureMax);
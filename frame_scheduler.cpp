@@ -0,0 +1,88 @@
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+namespace {
+
+std::chrono::steady_clock::duration fromSeconds(double seconds) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+} // namespace
+
+FrameScheduler::FrameScheduler(const PacingConfig& config, float timestep, std::function<Clock::time_point()> now)
+    : now(std::move(now)),
+      mode(config.mode),
+      framePeriod(fromSeconds(1.0 / std::max(1.0f, config.targetFps))),
+      timestep(fromSeconds(timestep)),
+      maxStepsPerFrame(std::max(1, config.maxStepsPerFrame)),
+      reportInterval(fromSeconds(config.reportInterval)),
+      windowSteps(0),
+      windowFrames(0),
+      rates({0.0f, 0.0f, 0, 0}) {
+    Clock::time_point start = this->now();
+    frameStart = start;
+    nextFrame = start + framePeriod;
+    accumulator = this->timestep; // the first frame shows one step
+    windowStart = start;
+    lastReport = start;
+}
+
+int FrameScheduler::beginFrame() {
+    Clock::time_point time = now();
+    Clock::duration elapsed = time - frameStart;
+    frameStart = time;
+
+    if (mode == PacingMode::VSYNC && elapsed > framePeriod + framePeriod / 2) {
+        rates.droppedFrames += (elapsed + framePeriod / 2) / framePeriod - 1;
+    }
+    if (mode == PacingMode::UNCAPPED || timestep.count() <= 0) {
+        return 1;
+    }
+
+    accumulator += elapsed;
+    long long steps = accumulator / timestep;
+    accumulator -= steps * timestep;
+    if (steps > maxStepsPerFrame) {
+        rates.droppedSteps += steps - maxStepsPerFrame;
+        steps = maxStepsPerFrame;
+    }
+    return static_cast<int>(steps);
+}
+
+void FrameScheduler::addSteps(long long steps) {
+    windowSteps += steps;
+}
+
+void FrameScheduler::endFrame() {
+    Clock::time_point time = now();
+    windowFrames++;
+    Clock::duration window = time - windowStart;
+    if (window >= std::chrono::seconds(1)) {
+        double length = std::chrono::duration<double>(window).count();
+        rates.stepsPerSecond = static_cast<float>(windowSteps / length);
+        rates.framesPerSecond = static_cast<float>(windowFrames / length);
+        windowSteps = 0;
+        windowFrames = 0;
+        windowStart = time;
+    }
+
+    if (mode != PacingMode::FIXED) return;
+    if (time > nextFrame) {
+        // missed the deadline: count the skipped intervals and restart the schedule
+        rates.droppedFrames += 1 + (time - nextFrame) / framePeriod;
+        nextFrame = time + framePeriod;
+        return;
+    }
+    std::this_thread::sleep_until(nextFrame);
+    nextFrame += framePeriod;
+}
+
+bool FrameScheduler::reportDue() {
+    if (reportInterval.count() <= 0) return false;
+    Clock::time_point time = now();
+    if (time - lastReport < reportInterval) return false;
+    lastReport = time;
+    return true;
+}
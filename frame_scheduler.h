@@ -0,0 +1,69 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <chrono>
+#include <functional>
+#include "config.h"
+
+// frame pacing of the main loop (pacing.mode):
+//  - FIXED: endFrame() sleeps until the next frame is due at targetFps; frames that finish
+//    after their deadline count as dropped, one per missed interval, and the schedule
+//    restarts from the late frame instead of catching up
+//  - VSYNC: no sleeping, presentation blocks on the display; frame intervals longer than
+//    1.5 target intervals count the missed ones as dropped
+//  - UNCAPPED: no waiting anywhere and one simulation step per frame
+//
+// when the main loop steps the simulator, beginFrame() returns how many fixed timesteps
+// the wall clock time since the previous frame is worth (accumulator, capped at
+// maxStepsPerFrame; time beyond the cap is dropped and the simulation runs slower). the
+// default cap of 1 never runs more steps than frames: a step slower than a frame then
+// slows the simulation down instead of multiplying the frame time
+//
+//     int steps = scheduler.beginFrame();
+//     for (int n = 0; n < steps; n++) simulator.update();
+//     scheduler.addSteps(steps);
+//     renderer.render(simulator);
+//     scheduler.endFrame();
+class FrameScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // now is the time source, replaceable for tests
+    FrameScheduler(const PacingConfig& config, float timestep,
+                   std::function<Clock::time_point()> now = Clock::now);
+
+    int beginFrame();
+    // simulation steps completed this frame, counted for the step rate
+    void addSteps(long long steps);
+    void endFrame();
+
+    struct Rates {
+        float stepsPerSecond; // over the last full second
+        float framesPerSecond;
+        long long droppedFrames; // since start
+        long long droppedSteps;
+    };
+    Rates getRates() const { return rates; }
+
+    // true once every pacing.reportInterval seconds (never when 0)
+    bool reportDue();
+
+private:
+    std::function<Clock::time_point()> now;
+    PacingMode mode;
+    Clock::duration framePeriod;
+    Clock::duration timestep;
+    int maxStepsPerFrame;
+    Clock::duration reportInterval;
+
+    Clock::time_point frameStart; // of the current frame
+    Clock::time_point nextFrame; // FIXED deadline
+    Clock::duration accumulator;
+
+    Clock::time_point windowStart; // rates are averaged over one second windows
+    long long windowSteps, windowFrames;
+    Rates rates;
+    Clock::time_point lastReport;
+};
+
+#endif
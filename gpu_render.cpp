@@ -34,7 +34,9 @@ WebGPURenderer::WebGPURenderer(SDL_Window* window, const Config& config)
       redInkTextureView(nullptr),
       greenInkTextureView(nullptr),
       blueInkTextureView(nullptr),
+      scalarTextureFormat(WGPUTextureFormat_R32Float),
       initialized(false),
+      pacingMode(config.pacing.mode),
       drawTarget(config.rendering.target),
       showVelocityVectors(config.rendering.showVelocityVectors),
       disableHistograms(config.rendering.disableHistograms),
@@ -47,8 +49,10 @@ WebGPURenderer::WebGPURenderer(SDL_Window* window, const Config& config)
       velocityHistogramBins(IRenderer::HISTOGRAM_BINS, 0),
       velocityHistogramMin(0.0f),
       velocityHistogramMax(0.0f),
-      velocityHistogramMaxCount(0)
+      velocityHistogramMaxCount(0),
+      profiler({"frame", "histograms", "upload", "draw"})
 {
+    profiler.setEnabled(config.profiling.enabled);
 
     SDL_GetWindowSize(window, &windowWidth, &windowHeight);
 
@@ -325,6 +329,20 @@ bool WebGPURenderer::initSurface() {
     surfaceConfig.width = windowWidth;
     surfaceConfig.height = windowHeight;
     surfaceConfig.presentMode = WGPUPresentMode_Fifo;
+    if (pacingMode == PacingMode::UNCAPPED) {
+        // uncapped frames present without waiting for the display, when the surface can
+        WGPUSurfaceCapabilities capabilities = {};
+        if (wgpuSurfaceGetCapabilities(surface, adapter, &capabilities) == WGPUStatus_Success) {
+            for (size_t n = 0; n < capabilities.presentModeCount; n++) {
+                WGPUPresentMode mode = capabilities.presentModes[n];
+                if (mode == WGPUPresentMode_Mailbox || mode == WGPUPresentMode_Immediate) {
+                    surfaceConfig.presentMode = mode;
+                    break;
+                }
+            }
+            wgpuSurfaceCapabilitiesFreeMembers(capabilities);
+        }
+    }
     surfaceConfig.alphaMode = WGPUCompositeAlphaMode_Opaque;
 
     wgpuSurfaceConfigure(surface, &surfaceConfig);
@@ -648,11 +666,15 @@ void WebGPURenderer::updateUniformData(const ISimulator& simulator) {
     uniformData.simWidth = uniformData.gridX * uniformData.cellSize;
     uniformData.simHeight = uniformData.gridY * uniformData.cellSize;
 
-    // pressure range
+    // pressure range; vorticity mode reuses the pressure texture with a symmetric range
     const auto& pressure = simulator.getPressure();
-    if (!pressure.empty()) {
-        uniformData.pressureMin = *std::min_element(pressure.begin(), pressure.end());
-        uniformData.pressureMax = *std::max_element(pressure.begin(), pressure.end());
+    const auto& vorticity = simulator.getVorticity();
+    if (drawTarget == 4 && !vorticity.empty()) {
+        float maxW = maxMagnitude(vorticity);
+        uniformData.pressureMin = -maxW;
+        uniformData.pressureMax = maxW;
+    } else {
+        fieldRange(pressure, uniformData.pressureMin, uniformData.pressureMax);
     }
 
     // histogram data
@@ -682,8 +704,15 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
     int gridX = simulator.getGridX();
     int gridY = simulator.getGridY();
 
-    // create textures initially or on resize
-    if (!pressureTexture || uniformData.gridX != gridX || uniformData.gridY != gridY) {
+    // density and ink are uploaded as half floats when the simulator stores them in 16 bits
+    WGPUTextureFormat scalarFormat = simulator.getDensity().precision() == ScalarPrecision::FP32 ?
+                                     WGPUTextureFormat_R32Float : WGPUTextureFormat_R16Float;
+
+    // create textures initially, on resize or when the scalar precision changes
+    if (!pressureTexture || uniformData.gridX != gridX || uniformData.gridY != gridY ||
+        scalarFormat != scalarTextureFormat) {
+        scalarTextureFormat = scalarFormat;
+
         // release old textures (views first, then textures)
         if (pressureTextureView) {
             wgpuTextureViewRelease(pressureTextureView);
@@ -762,6 +791,7 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
         pressureTexture = wgpuDeviceCreateTexture(device, &textureDesc);
 
         textureDesc.label = "Density Texture";
+        textureDesc.format = scalarTextureFormat;
         densityTexture = wgpuDeviceCreateTexture(device, &textureDesc);
 
         textureDesc.label = "Velocity Texture";
@@ -772,7 +802,8 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
         textureDesc.format = WGPUTextureFormat_R32Float; // single channel for solid/fluid
         solidTexture = wgpuDeviceCreateTexture(device, &textureDesc);
 
-        // create ink textures with the same dimensions as other textures
+        // create ink textures with the same dimensions and format as the density texture
+        textureDesc.format = scalarTextureFormat;
         textureDesc.label = "Red Ink Texture";
         redInkTexture = wgpuDeviceCreateTexture(device, &textureDesc);
 
@@ -799,6 +830,8 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
         viewDesc.arrayLayerCount = 1;
 
         pressureTextureView = wgpuTextureCreateView(pressureTexture, &viewDesc);
+
+        viewDesc.format = scalarTextureFormat;
         densityTextureView = wgpuTextureCreateView(densityTexture, &viewDesc);
 
         viewDesc.format = WGPUTextureFormat_RG32Float;
@@ -808,6 +841,7 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
         solidTextureView = wgpuTextureCreateView(solidTexture, &viewDesc);
 
         // create ink texture views
+        viewDesc.format = scalarTextureFormat;
         redInkTextureView = wgpuTextureCreateView(redInkTexture, &viewDesc);
         greenInkTextureView = wgpuTextureCreateView(greenInkTexture, &viewDesc);
         blueInkTextureView = wgpuTextureCreateView(blueInkTexture, &viewDesc);
@@ -874,13 +908,18 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
         }
     }
 
-    // update texture data
-    const auto& pressure = simulator.getPressure();
+    // update texture data (vorticity mode draws the curl through the pressure texture)
+    const auto& pressure = (drawTarget == 4 && !simulator.getVorticity().empty()) ?
+                           simulator.getVorticity() : simulator.getPressure();
     const auto& density = simulator.getDensity();
     const auto& velocityX = simulator.getVelocityX();
     const auto& velocityY = simulator.getVelocityY();
     const auto& solid = simulator.getSolid();
 
+    // fields are padded; upload only the grid rows out of each padded row
+    uint64_t fieldOffset = static_cast<uint64_t>(simulator.getFieldOffset());
+    int fieldStride = simulator.getFieldStride();
+
     if (!pressure.empty()) {
         // write pressure data to texture
         WGPUImageCopyTexture pressureCopy = {
@@ -891,8 +930,8 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
         };
 
         WGPUTextureDataLayout pressureLayout = {
-            .offset = 0,
-            .bytesPerRow = static_cast<uint32_t>(gridX * sizeof(float)),
+            .offset = fieldOffset * sizeof(float),
+            .bytesPerRow = static_cast<uint32_t>(fieldStride * sizeof(float)),
             .rowsPerImage = static_cast<uint32_t>(gridY)
         };
 
@@ -907,27 +946,7 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
 
         // write density data to texture
         if (!density.empty()) {
-            WGPUImageCopyTexture densityCopy = {
-                .texture = densityTexture,
-                .mipLevel = 0,
-                .origin = {0, 0, 0},
-                .aspect = WGPUTextureAspect_All
-            };
-
-            WGPUTextureDataLayout densityLayout = {
-                .offset = 0,
-                .bytesPerRow = static_cast<uint32_t>(gridX * sizeof(float)),
-                .rowsPerImage = static_cast<uint32_t>(gridY)
-            };
-
-            WGPUExtent3D densityExtent = {
-                .width = static_cast<uint32_t>(gridX),
-                .height = static_cast<uint32_t>(gridY),
-                .depthOrArrayLayers = 1
-            };
-
-            wgpuQueueWriteTexture(queue, &densityCopy, density.data(),
-                               density.size() * sizeof(float), &densityLayout, &densityExtent);
+            writeScalarTexture(densityTexture, density, gridX, gridY, fieldOffset, fieldStride);
         }
 
         // write velocity data to texture
@@ -948,8 +967,8 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
             };
 
             WGPUTextureDataLayout velocityLayout = {
-                .offset = 0,
-                .bytesPerRow = static_cast<uint32_t>(gridX * 2 * sizeof(float)),
+                .offset = fieldOffset * 2 * sizeof(float),
+                .bytesPerRow = static_cast<uint32_t>(fieldStride * 2 * sizeof(float)),
                 .rowsPerImage = static_cast<uint32_t>(gridY)
             };
 
@@ -973,8 +992,8 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
             };
 
             WGPUTextureDataLayout solidLayout = {
-                .offset = 0,
-                .bytesPerRow = static_cast<uint32_t>(gridX * sizeof(float)),
+                .offset = fieldOffset * sizeof(float),
+                .bytesPerRow = static_cast<uint32_t>(fieldStride * sizeof(float)),
                 .rowsPerImage = static_cast<uint32_t>(gridY)
             };
 
@@ -995,90 +1014,83 @@ void WebGPURenderer::updateSimulationTextures(const ISimulator& simulator) {
 
         // only process those textures if the simulator has ink initialized
         if (simulator.isInkInitialized() && !redInk.empty()) {
-            WGPUImageCopyTexture redInkCopy = {
-                .texture = redInkTexture,
-                .mipLevel = 0,
-                .origin = {0, 0, 0},
-                .aspect = WGPUTextureAspect_All
-            };
-
-            WGPUTextureDataLayout redInkLayout = {
-                .offset = 0,
-                .bytesPerRow = static_cast<uint32_t>(gridX * sizeof(float)),
-                .rowsPerImage = static_cast<uint32_t>(gridY)
-            };
-
-            WGPUExtent3D redInkExtent = {
-                .width = static_cast<uint32_t>(gridX),
-                .height = static_cast<uint32_t>(gridY),
-                .depthOrArrayLayers = 1
-            };
-
-            wgpuQueueWriteTexture(queue, &redInkCopy, redInk.data(),
-                                   redInk.size() * sizeof(float), &redInkLayout, &redInkExtent);
+            writeScalarTexture(redInkTexture, redInk, gridX, gridY, fieldOffset, fieldStride);
         }
-
         if (!greenInk.empty()) {
-            WGPUImageCopyTexture greenInkCopy = {
-                .texture = greenInkTexture,
-                .mipLevel = 0,
-                .origin = {0, 0, 0},
-                .aspect = WGPUTextureAspect_All
-            };
-
-            WGPUTextureDataLayout greenInkLayout = {
-                .offset = 0,
-                .bytesPerRow = static_cast<uint32_t>(gridX * sizeof(float)),
-                .rowsPerImage = static_cast<uint32_t>(gridY)
-            };
-
-            WGPUExtent3D greenInkExtent = {
-                .width = static_cast<uint32_t>(gridX),
-                .height = static_cast<uint32_t>(gridY),
-                .depthOrArrayLayers = 1
-            };
-
-            wgpuQueueWriteTexture(queue, &greenInkCopy, greenInk.data(),
-                                   greenInk.size() * sizeof(float), &greenInkLayout, &greenInkExtent);
+            writeScalarTexture(greenInkTexture, greenInk, gridX, gridY, fieldOffset, fieldStride);
         }
-
         if (!blueInk.empty()) {
-            WGPUImageCopyTexture blueInkCopy = {
-                .texture = blueInkTexture,
-                .mipLevel = 0,
-                .origin = {0, 0, 0},
-                .aspect = WGPUTextureAspect_All
-            };
+            writeScalarTexture(blueInkTexture, blueInk, gridX, gridY, fieldOffset, fieldStride);
+        }
+    }
+}
 
-            WGPUTextureDataLayout blueInkLayout = {
-                .offset = 0,
-                .bytesPerRow = static_cast<uint32_t>(gridX * sizeof(float)),
-                .rowsPerImage = static_cast<uint32_t>(gridY)
-            };
+void WebGPURenderer::writeScalarTexture(WGPUTexture texture, const FieldView& field, int gridX, int gridY,
+                                        uint64_t fieldOffset, int fieldStride) {
+    WGPUImageCopyTexture copy = {
+        .texture = texture,
+        .mipLevel = 0,
+        .origin = {0, 0, 0},
+        .aspect = WGPUTextureAspect_All
+    };
 
-            WGPUExtent3D blueInkExtent = {
-                .width = static_cast<uint32_t>(gridX),
-                .height = static_cast<uint32_t>(gridY),
-                .depthOrArrayLayers = 1
-            };
+    // fp32 and fp16 fields are copied straight out of the padded storage
+    const void* data = field.data();
+    size_t elementBytes = field.elementBytes();
+    size_t dataSize = field.size() * elementBytes;
+    WGPUTextureDataLayout layout = {
+        .offset = fieldOffset * elementBytes,
+        .bytesPerRow = static_cast<uint32_t>(fieldStride * elementBytes),
+        .rowsPerImage = static_cast<uint32_t>(gridY)
+    };
 
-            wgpuQueueWriteTexture(queue, &blueInkCopy, blueInk.data(),
-                                   blueInk.size() * sizeof(float), &blueInkLayout, &blueInkExtent);
+    // WebGPU has no bfloat16 format, so bf16 fields are repacked as fp16 (density and
+    // ink stay well inside the fp16 range)
+    if (field.precision() == ScalarPrecision::BF16) {
+        scalarUploadData.resize(static_cast<size_t>(gridX) * gridY);
+        for (int j = 0; j < gridY; j++) {
+            for (int i = 0; i < gridX; i++) {
+                float value = field[fieldOffset + static_cast<size_t>(j) * fieldStride + i];
+                scalarUploadData[static_cast<size_t>(j) * gridX + i] = floatToHalfBits(value);
+            }
         }
+        data = scalarUploadData.data();
+        dataSize = scalarUploadData.size() * sizeof(uint16_t);
+        layout.offset = 0;
+        layout.bytesPerRow = static_cast<uint32_t>(gridX * sizeof(uint16_t));
     }
+
+    WGPUExtent3D extent = {
+        .width = static_cast<uint32_t>(gridX),
+        .height = static_cast<uint32_t>(gridY),
+        .depthOrArrayLayers = 1
+    };
+
+    wgpuQueueWriteTexture(queue, &copy, data, dataSize, &layout, &extent);
 }
 
 void WebGPURenderer::render(const ISimulator& simulator) {
     if (!initialized) return;
+    PROFILE_STAGE(profiler, STAGE_FRAME);
+
+    {
+        PROFILE_STAGE(profiler, STAGE_HISTOGRAMS);
+
+        // compute histograms every n frames
+        int histogramFrameInterval = 1;
+        if (!disableHistograms && frameCount++ % histogramFrameInterval == 0) {
+            computeHistograms(simulator);
+        }
+    }
 
-    // compute histograms every n frames
-    int histogramFrameInterval = 1;
-    if (!disableHistograms && frameCount++ % histogramFrameInterval == 0) {
-        computeHistograms(simulator);
+    {
+        PROFILE_STAGE(profiler, STAGE_UPLOAD);
+        updateUniformData(simulator);
+        updateSimulationTextures(simulator);
     }
 
-    updateUniformData(simulator);
-    updateSimulationTextures(simulator);
+    // surface acquire, encode, submit and present
+    PROFILE_STAGE(profiler, STAGE_DRAW);
 
     // get current texture from surface
     WGPUSurfaceTexture surfaceTexture;
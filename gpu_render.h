@@ -14,7 +14,7 @@ struct alignas(16) Vec4Int {
 };
 
 struct UniformData {
-    int drawTarget; // 0=pressure, 1=smoke, 2=both, 3=ink
+    int drawTarget; // 0=pressure, 1=smoke, 2=both, 3=ink, 4=vorticity
     int gridX;
     int gridY;
     float cellSize;
@@ -45,6 +45,7 @@ public:
     bool init(const Config& config) override;
     void cleanup() override {}
     void render(const ISimulator& simulator) override;
+    std::vector<StageStats> getStageStats() const override { return profiler.getStats(); }
 
 private:
     SDL_Window* window;
@@ -80,12 +81,15 @@ private:
     WGPUTextureView redInkTextureView;
     WGPUTextureView greenInkTextureView;
     WGPUTextureView blueInkTextureView;
+    WGPUTextureFormat scalarTextureFormat; // density and ink: R32Float, or R16Float for 16 bit storage
+    std::vector<uint16_t> scalarUploadData; // bf16 fields repacked as fp16
 
     // render state
     UniformData uniformData;
     bool initialized;
 
     // cached config values
+    PacingMode pacingMode; // FIXED and VSYNC present with vsync
     int drawTarget;
     bool showVelocityVectors;
     bool disableHistograms;
@@ -100,6 +104,10 @@ private:
     float velocityHistogramMin, velocityHistogramMax;
     int velocityHistogramMaxCount;
 
+    // stage timings of render(), indexed by Stage
+    enum Stage { STAGE_FRAME, STAGE_HISTOGRAMS, STAGE_UPLOAD, STAGE_DRAW };
+    StageProfiler profiler;
+
     // initialization methods
     bool initWebGPU();
     bool initDevice();
@@ -111,6 +119,8 @@ private:
     // render methods
     void updateUniformData(const ISimulator& simulator);
     void updateSimulationTextures(const ISimulator& simulator);
+    void writeScalarTexture(WGPUTexture texture, const FieldView& field, int gridX, int gridY,
+                            uint64_t fieldOffset, int fieldStride);
     void computeHistograms(const ISimulator& simulator);
     void createRenderPass();
     void drawFrame();
@@ -22,25 +22,34 @@ public:
     // grid params
     int getGridX() const override { return cpuSimulator.getGridX(); }
     int getGridY() const override { return cpuSimulator.getGridY(); }
+    int getFieldStride() const override { return cpuSimulator.getFieldStride(); }
+    int getFieldOffset() const override { return cpuSimulator.getFieldOffset(); }
     float getCellSize() const override { return cpuSimulator.getCellSize(); }
 
     float getDomainWidth() const override { return cpuSimulator.getDomainWidth(); }
     float getDomainHeight() const override { return cpuSimulator.getDomainHeight(); }
 
     // data accessors
-    const std::vector<float>& getVelocityX() const override { return cpuSimulator.getVelocityX(); }
-    const std::vector<float>& getVelocityY() const override { return cpuSimulator.getVelocityY(); }
-    const std::vector<float>& getPressure() const override { return cpuSimulator.getPressure(); }
-    const std::vector<float>& getDensity() const override { return cpuSimulator.getDensity(); }
-    const std::vector<float>& getSolid() const override { return cpuSimulator.getSolid(); }
+    FieldView getVelocityX() const override { return cpuSimulator.getVelocityX(); }
+    FieldView getVelocityY() const override { return cpuSimulator.getVelocityY(); }
+    FieldView getPressure() const override { return cpuSimulator.getPressure(); }
+    FieldView getDensity() const override { return cpuSimulator.getDensity(); }
+    FieldView getSolid() const override { return cpuSimulator.getSolid(); }
 
     bool isInsideCircle(int i, int j) override { return cpuSimulator.isInsideCircle(i, j); }
 
     // ink data accessors
-    const std::vector<float>& getRedInk() const override { return cpuSimulator.getRedInk(); }
-    const std::vector<float>& getGreenInk() const override { return cpuSimulator.getGreenInk(); }
-    const std::vector<float>& getBlueInk() const override { return cpuSimulator.getBlueInk(); }
+    FieldView getRedInk() const override { return cpuSimulator.getRedInk(); }
+    FieldView getGreenInk() const override { return cpuSimulator.getGreenInk(); }
+    FieldView getBlueInk() const override { return cpuSimulator.getBlueInk(); }
     bool isInkInitialized() const override { return cpuSimulator.isInkInitialized(); }
+    FieldView getVorticity() const override { return cpuSimulator.getVorticity(); }
+
+    // projection stats
+    int getProjectionIterations() const override { return cpuSimulator.getProjectionIterations(); }
+    float getProjectionResidual() const override { return cpuSimulator.getProjectionResidual(); }
+    std::vector<StageStats> getStageStats() const override { return cpuSimulator.getStageStats(); }
+    void resetStageStats() override { cpuSimulator.resetStageStats(); }
 private:
     FluidSimulator cpuSimulator;
 };
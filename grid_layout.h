@@ -0,0 +1,33 @@
+#ifndef GRID_LAYOUT_H
+#define GRID_LAYOUT_H
+
+// ghost layers around the grid; two on the high side let bilinear sampling at the
+// clamped domain edge read x0+1 and y0+1 without bounds checks
+static const int GHOST_LAYERS = 2;
+// rows (including their ghost cells) start on 64 byte boundaries for float fields
+static const int ROW_ALIGN_ELEMENTS = 16;
+
+// padded row-major storage of a gridX x gridY field; cell (i, j) lives at
+// origin + j * stride + i for -GHOST_LAYERS <= i < gridX + GHOST_LAYERS (same for j)
+struct GridLayout {
+    int gridX = 0, gridY = 0;
+    int stride = 0; // elements per row, including ghosts and alignment padding
+    int origin = 0; // storage index of cell (0, 0)
+    int size = 0; // elements per field
+
+    void init(int gridX, int gridY) {
+        this->gridX = gridX;
+        this->gridY = gridY;
+        int rowElements = gridX + 2 * GHOST_LAYERS;
+        stride = (rowElements + ROW_ALIGN_ELEMENTS - 1) / ROW_ALIGN_ELEMENTS * ROW_ALIGN_ELEMENTS;
+        origin = GHOST_LAYERS * stride + GHOST_LAYERS;
+        size = (gridY + 2 * GHOST_LAYERS) * stride;
+    }
+
+    int idx(int i, int j) const { return origin + j * stride + i; }
+    // inverse of idx for cells inside the grid
+    int column(int k) const { return (k - origin) % stride; }
+    int row(int k) const { return (k - origin) / stride; }
+};
+
+#endif
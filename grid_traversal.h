@@ -0,0 +1,215 @@
+#ifndef GRID_TRAVERSAL_H
+#define GRID_TRAVERSAL_H
+
+#include <omp.h>
+#include <algorithm>
+#include <vector>
+
+// half-open cell range [iBegin, iEnd) x [jBegin, jEnd)
+struct CellRange {
+    int iBegin, iEnd;
+    int jBegin, jEnd;
+};
+
+inline bool isEmpty(const CellRange& range) {
+    return range.iEnd <= range.iBegin || range.jEnd <= range.jBegin;
+}
+
+// smallest range covering both; an empty range adds nothing
+inline CellRange unite(const CellRange& a, const CellRange& b) {
+    if (isEmpty(a)) return b;
+    if (isEmpty(b)) return a;
+    return {std::min(a.iBegin, b.iBegin), std::max(a.iEnd, b.iEnd),
+            std::min(a.jBegin, b.jBegin), std::max(a.jEnd, b.jEnd)};
+}
+
+// checkerboard color of a cell: cells of one color never share a face
+inline int firstOfColor(int iBegin, int j, int color) {
+    return iBegin + ((iBegin + j + color) & 1);
+}
+
+// traversal order and parallel schedule for every grid kernel. a range is cut into
+// tiles of tileRows x tileCols cells (tileCols = 0: whole rows); each tile is walked
+// row by row and the kernel gets one contiguous row span at a time:
+//
+//     span(int j, int iBegin, int iEnd)
+//
+// tiles are handed out with a static schedule, so the tile -> thread mapping only
+// depends on the tile size and the thread count. the *InParallel variants are
+// orphaned worksharing loops for use inside an enclosing omp parallel region.
+// spans are copied per tile; hot kernels hoist their pointers into locals and capture
+// them by value, so the row loop keeps them in registers
+class GridTraversal {
+public:
+    GridTraversal() : tileRows(8), tileCols(0) {}
+
+    void setTileSize(int rows, int cols) {
+        tileRows = std::max(1, rows);
+        tileCols = std::max(0, cols);
+    }
+    int getTileRows() const { return tileRows; }
+    int getTileCols() const { return tileCols; }
+
+    // parallel over tiles
+    template <typename Span>
+    void forEachRow(const CellRange& range, Span&& span) const {
+        #pragma omp parallel
+        forEachRowInParallel(range, span);
+    }
+
+    template <typename Span>
+    void forEachRowInParallel(const CellRange& range, Span&& span) const {
+        Tiling t = tiling(range);
+        #pragma omp for schedule(static)
+        for (int tile = 0; tile < t.count(); tile++) {
+            visitTile(range, t, tile, span);
+        }
+    }
+
+    // in lexicographic row-major order on the calling thread (Gauss-Seidel, obstacle edits)
+    template <typename Span>
+    void forEachRowSerial(const CellRange& range, Span&& span) const {
+        if (range.iEnd <= range.iBegin) return;
+        for (int j = range.jBegin; j < range.jEnd; j++) {
+            span(j, range.iBegin, range.iEnd);
+        }
+    }
+
+    // max over the values returned by span (float or double); max is order independent,
+    // so the result doesn't depend on the thread count
+    template <typename Span>
+    auto maxOverRows(const CellRange& range, Span&& span) const -> decltype(span(0, 0, 0)) {
+        decltype(span(0, 0, 0)) result = 0;
+        #pragma omp parallel
+        maxOverRowsInParallel(range, result, span);
+        return result;
+    }
+
+    // result must be shared; every thread returns after it holds the final max
+    template <typename T, typename Span>
+    void maxOverRowsInParallel(const CellRange& range, T& result, Span&& span) const {
+        Tiling t = tiling(range);
+        T local = 0;
+        #pragma omp for schedule(static) nowait
+        for (int tile = 0; tile < t.count(); tile++) {
+            visitTile(range, t, tile, [&](int j, int iBegin, int iEnd) {
+                local = std::max(local, span(j, iBegin, iEnd));
+            });
+        }
+        #pragma omp critical(grid_traversal_max)
+        result = std::max(result, local);
+        #pragma omp barrier
+    }
+
+    // sum of the values returned by span; one partial per row span, added serially in
+    // row-major order so the result doesn't depend on the thread count
+    template <typename T, typename Span>
+    T sumOverRows(const CellRange& range, Span&& span) const {
+        Tiling t = tiling(range);
+        std::vector<T> partials(static_cast<size_t>(t.rows) * t.tilesX);
+        #pragma omp parallel for schedule(static)
+        for (int tile = 0; tile < t.count(); tile++) {
+            int tileX = tile % t.tilesX;
+            visitTile(range, t, tile, [&](int j, int iBegin, int iEnd) {
+                partials[static_cast<size_t>(j - range.jBegin) * t.tilesX + tileX] = span(j, iBegin, iEnd);
+            });
+        }
+
+        T total = T();
+        for (const T& partial : partials) {
+            total += partial;
+        }
+        return total;
+    }
+
+    // temporal blocking for Gauss-Seidel style passes, where a cell needs the previous
+    // pass over its four neighbors: runs `passes` passes as one wavefront over blocks of
+    // tileRows rows by tileCols cells (tileCols = 0: one column chunk per thread). pass p
+    // runs two row blocks behind pass p-1, so a block is revisited by every pass while it
+    // is still in cache. ordered passes (lexicographic Gauss-Seidel, where a cell also
+    // needs its left neighbor from the same pass) run chunk c one step after chunk c-1;
+    // unordered ones (one red-black color) run every chunk of a row block together. as
+    // long as span only touches cells next to the one it relaxes, the result equals
+    // running the passes one after another, for any thread count. the blocks of one step
+    // run in parallel with one barrier per step, so a step holds at most passes x chunks
+    // blocks and the pipeline takes 2 * (passes - 1) steps to fill; passMax[p] gets the
+    // max returned by span in pass p
+    //
+    //     T span(int pass, int j, int iBegin, int iEnd)
+    template <typename T, typename Span>
+    void maxOverRowWavefront(const CellRange& range, int passes, bool ordered, T* passMax, Span&& span) const {
+        std::fill(passMax, passMax + passes, T(0));
+        const int rows = range.jEnd - range.jBegin;
+        const int cols = range.iEnd - range.iBegin;
+        if (rows <= 0 || cols <= 0) return;
+        const int bands = (rows + tileRows - 1) / tileRows;
+
+        #pragma omp parallel
+        {
+            int threads = omp_get_num_threads();
+            int width = tileCols > 0 ? tileCols : (cols + threads - 1) / threads;
+            int chunks = (cols + width - 1) / width;
+            int steps = bands + 2 * (passes - 1) + (ordered ? chunks - 1 : 0);
+
+            std::vector<T> local(passes, T(0));
+            for (int step = 0; step < steps; step++) {
+                #pragma omp for schedule(static)
+                for (int block = 0; block < passes * chunks; block++) {
+                    int pass = block / chunks;
+                    int chunk = block % chunks;
+                    int band = step - 2 * pass - (ordered ? chunk : 0);
+                    if (band < 0 || band >= bands) continue;
+
+                    int jBegin = range.jBegin + band * tileRows;
+                    int jEnd = std::min(range.jEnd, jBegin + tileRows);
+                    int iBegin = range.iBegin + chunk * width;
+                    int iEnd = std::min(range.iEnd, iBegin + width);
+                    for (int j = jBegin; j < jEnd; j++) {
+                        local[pass] = std::max(local[pass], span(pass, j, iBegin, iEnd));
+                    }
+                }
+            }
+            #pragma omp critical(grid_traversal_wavefront)
+            for (int pass = 0; pass < passes; pass++) {
+                passMax[pass] = std::max(passMax[pass], local[pass]);
+            }
+        }
+    }
+
+private:
+    int tileRows;
+    int tileCols; // 0 = whole rows
+
+    struct Tiling {
+        int rows, cols;
+        int height, width; // tile size, clamped to the range
+        int tilesX, tilesY;
+        int count() const { return tilesX * tilesY; }
+    };
+
+    Tiling tiling(const CellRange& range) const {
+        Tiling t;
+        t.rows = std::max(0, range.jEnd - range.jBegin);
+        t.cols = std::max(0, range.iEnd - range.iBegin);
+        t.height = tileRows;
+        t.width = tileCols > 0 ? tileCols : std::max(1, t.cols);
+        t.tilesY = t.cols > 0 ? (t.rows + t.height - 1) / t.height : 0;
+        t.tilesX = (t.cols + t.width - 1) / t.width;
+        return t;
+    }
+
+    template <typename Span>
+    static void visitTile(const CellRange& range, const Tiling& t, int tile, Span span) {
+        int tileY = tile / t.tilesX;
+        int tileX = tile % t.tilesX;
+        int jBegin = range.jBegin + tileY * t.height;
+        int jEnd = std::min(range.jEnd, jBegin + t.height);
+        int iBegin = range.iBegin + tileX * t.width;
+        int iEnd = std::min(range.iEnd, iBegin + t.width);
+        for (int j = jBegin; j < jEnd; j++) {
+            span(j, iBegin, iEnd);
+        }
+    }
+};
+
+#endif
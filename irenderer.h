@@ -15,6 +15,30 @@ public:
     virtual void cleanup() = 0;
     virtual void render(const ISimulator& simulator) = 0;
 
+    // rolling per-stage timings of render(); empty when profiling is unavailable
+    virtual std::vector<StageStats> getStageStats() const { return {}; }
+
+    // value range of a whole padded field, reused between both renderers; ghost and
+    // padding cells hold 0 like the solid border. leaves the outputs alone when empty
+    static void fieldRange(const FieldView& field, float& minValue, float& maxValue) {
+        if (field.empty()) return;
+        minValue = field[0];
+        maxValue = field[0];
+        for (size_t i = 0; i < field.size(); i++) {
+            minValue = std::min(minValue, field[i]);
+            maxValue = std::max(maxValue, field[i]);
+        }
+    }
+
+    // largest magnitude in a field, for ranges symmetric around zero
+    static float maxMagnitude(const FieldView& field) {
+        float maxValue = 0.0f;
+        for (size_t i = 0; i < field.size(); i++) {
+            maxValue = std::max(maxValue, std::fabs(field[i]));
+        }
+        return maxValue;
+    }
+
     // histogram computation reused between both renderers
     static constexpr int HISTOGRAM_BINS = 64;
     
@@ -32,12 +56,13 @@ public:
         const auto& solid = simulator.getSolid();
         const auto& velocityX = simulator.getVelocityX();
         const auto& velocityY = simulator.getVelocityY();
-        int gridX = simulator.getGridX();
-        int gridY = simulator.getGridY();
+        // fields are padded (see getFieldStride); ghost and padding cells are solid, so
+        // walking the whole buffer visits exactly the fluid cells
+        int cells = static_cast<int>(solid.size());
 
         // density histogram (using pressure)
         bool first = true;
-        for (int i = 0; i < gridX * gridY; i++) {
+        for (int i = 0; i < cells; i++) {
             if (solid[i] != 0.0f) { // only fluid cells
                 if (first) {
                     data.densityHistogramMin = pressure[i];
@@ -53,7 +78,7 @@ public:
         
         if (data.densityHistogramMax > data.densityHistogramMin) {
             float binWidth = (data.densityHistogramMax - data.densityHistogramMin) / HISTOGRAM_BINS;
-            for (int i = 0; i < gridX * gridY; i++) {
+            for (int i = 0; i < cells; i++) {
                 if (solid[i] != 0.0f) { // only fluid cells
                     int bin = static_cast<int>((pressure[i] - data.densityHistogramMin) / binWidth);
                     bin = std::max(0, std::min(HISTOGRAM_BINS - 1, bin));
@@ -64,7 +89,7 @@ public:
         
         // velocity histogram
         first = true;
-        for (int i = 0; i < gridX * gridY; i++) {
+        for (int i = 0; i < cells; i++) {
             if (solid[i] != 0.0f) { // only fluid cells
                 float velMagnitude = std::sqrt(velocityX[i] * velocityX[i] + velocityY[i] * velocityY[i]);
                 if (first) {
@@ -82,7 +107,7 @@ public:
         
         if (data.velocityHistogramMax > data.velocityHistogramMin) {
             float binWidth = (data.velocityHistogramMax - data.velocityHistogramMin) / HISTOGRAM_BINS;
-            for (int i = 0; i < gridX * gridY; i++) {
+            for (int i = 0; i < cells; i++) {
                 if (solid[i] != 0.0f) { // only fluid cells
                     float velMagnitude = std::sqrt(velocityX[i] * velocityX[i] + velocityY[i] * velocityY[i]);
                     int bin = static_cast<int>((velMagnitude - data.velocityHistogramMin) / binWidth);
@@ -3,6 +3,8 @@
 
 #include <vector>
 #include "config.h"
+#include "profiler.h"
+#include "field_arena.h"
 
 struct ImageData {
     void* pixels;
@@ -32,21 +34,36 @@ public:
     // grid dimensions
     virtual int getGridX() const = 0;
     virtual int getGridY() const = 0;
+    // field storage: cell (i, j) is at getFieldOffset() + j * getFieldStride() + i
+    virtual int getFieldStride() const { return getGridX(); }
+    virtual int getFieldOffset() const { return 0; }
     virtual float getCellSize() const = 0;
 
     // domain dimensions
     virtual float getDomainWidth() const = 0;
     virtual float getDomainHeight() const = 0;
 
-    // data accessors
-    virtual const std::vector<float>& getVelocityX() const = 0;
-    virtual const std::vector<float>& getVelocityY() const = 0;
-    virtual const std::vector<float>& getPressure() const = 0;
-    virtual const std::vector<float>& getDensity() const = 0;
-    virtual const std::vector<float>& getSolid() const = 0;
-    virtual const std::vector<float>& getRedInk() const { static std::vector<float> empty; return empty; }
-    virtual const std::vector<float>& getGreenInk() const { static std::vector<float> empty; return empty; }
-    virtual const std::vector<float>& getBlueInk() const { static std::vector<float> empty; return empty; }
+    // data accessors; views stay valid until the next update() or init()
+    virtual FieldView getVelocityX() const = 0;
+    virtual FieldView getVelocityY() const = 0;
+    virtual FieldView getPressure() const = 0;
+    virtual FieldView getDensity() const = 0;
+    virtual FieldView getSolid() const = 0;
+    virtual FieldView getRedInk() const { return FieldView(); }
+    virtual FieldView getGreenInk() const { return FieldView(); }
+    virtual FieldView getBlueInk() const { return FieldView(); }
+    virtual FieldView getVorticity() const { return FieldView(); }
+
+    // projection stats from the last step (iterations or cycles used, max residual)
+    virtual int getProjectionIterations() const { return 0; }
+    virtual float getProjectionResidual() const { return 0.0f; }
+
+    // share of grid tiles the last step advected (1 without activity tracking)
+    virtual float getActiveTileFraction() const { return 1.0f; }
+
+    // rolling per-stage timings of update(); empty when profiling is unavailable
+    virtual std::vector<StageStats> getStageStats() const { return {}; }
+    virtual void resetStageStats() {}
 
     // misc
     virtual bool isInkInitialized() const { return false; }
@@ -0,0 +1,126 @@
+// headless benchmark: steps the CPU simulator (float or double, per simulation.realType) without a window and prints CSV
+//
+// usage: ./katara_bench [--config path] [--resolution 100,200] [--threads 1,4]
+//                       [--steps 200] [--warmup 20] [--no-header]
+// resolution and thread lists run every combination, one CSV row each
+
+#include "sim.h"
+#include "config.h"
+#include <omp.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::vector<int> parseList(const char* arg) {
+    std::vector<int> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+static void printUsage() {
+    std::cerr << "usage: katara_bench [--config path] [--resolution list] [--threads list] "
+              << "[--steps n] [--warmup n] [--no-header]" << std::endl;
+}
+
+// ink needs an image, so the benchmark always runs the smoke/pressure simulation
+template <typename Real>
+static void runCase(const Config& config, int threads, int steps, int warmup, bool header) {
+    BasicFluidSimulator<Real> simulator(config);
+    simulator.init(config);
+
+    for (int n = 0; n < warmup; n++) simulator.update();
+    simulator.resetStageStats();
+
+    double activeTiles = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < steps; n++) {
+        simulator.update();
+        activeTiles += simulator.getActiveTileFraction();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<StageStats> stats = simulator.getStageStats();
+    if (header) {
+        std::printf("resolution,grid_x,grid_y,threads,real,kernel,field_mib,huge_pages,steps,steps_per_s,ms_per_step,active_tiles");
+        for (const StageStats& stage : stats) {
+            std::printf(",%s_mean_ms,%s_p99_ms", stage.name.c_str(), stage.name.c_str());
+        }
+        std::printf("\n");
+    }
+
+    const FieldArena& arena = simulator.getFieldArena();
+    std::printf("%d,%d,%d,%d,%s,%s,%.2f,%d,%d,%.3f,%.4f,%.3f", config.simulation.resolution, simulator.getGridX(),
+                simulator.getGridY(), threads, sizeof(Real) == sizeof(double) ? "double" : "float",
+                simulator.getAdvectionKernel(), arena.getFootprintBytes() / (1024.0 * 1024.0),
+                arena.usesHugePages() ? 1 : 0, steps, steps / elapsed.count(), 1000.0 * elapsed.count() / steps,
+                activeTiles / steps);
+    for (const StageStats& stage : stats) {
+        double mean = stage.calls > 0 ? stage.totalMs / stage.calls : 0.0;
+        std::printf(",%.4f,%.4f", mean, stage.p99Ms);
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    std::string configPath = "../config.json";
+    std::vector<int> resolutions;
+    std::vector<int> threadCounts;
+    int steps = 200;
+    int warmup = 20;
+    bool header = true;
+
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if (!std::strcmp(argv[a], "--config") && hasValue) {
+            configPath = argv[++a];
+        } else if (!std::strcmp(argv[a], "--resolution") && hasValue) {
+            resolutions = parseList(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--threads") && hasValue) {
+            threadCounts = parseList(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--steps") && hasValue) {
+            steps = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--warmup") && hasValue) {
+            warmup = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--no-header")) {
+            header = false;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    Config config = ConfigLoader::loadConfig(configPath);
+    config.profiling.enabled = true;
+    if (resolutions.empty()) resolutions.push_back(config.simulation.resolution);
+    if (threadCounts.empty()) threadCounts.push_back(omp_get_max_threads());
+    if (steps <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    bool first = true;
+    for (int resolution : resolutions) {
+        for (int threads : threadCounts) {
+            omp_set_num_threads(threads);
+            config.simulation.resolution = resolution;
+            if (config.simulation.realType == RealType::DOUBLE) {
+                runCase<double>(config, threads, steps, warmup, header && first);
+            } else {
+                runCase<float>(config, threads, steps, warmup, header && first);
+            }
+            first = false;
+        }
+    }
+
+    return 0;
+}
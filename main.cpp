@@ -7,10 +7,13 @@
 #include <SDL2/SDL_image.h>
 #include <string>
 #include <memory>
+#include <cstdio>
 #include "sim.h"
 #include "render.h"
 #include "gpu_render.h"
 #include "gpu_sim.h"
+#include "sim_thread.h"
+#include "frame_scheduler.h"
 #include "irenderer.h"
 #include "isimulator.h"
 #include "config.h"
@@ -26,10 +29,10 @@ std::unique_ptr<ISimulator> createSimulator(const Config& config) {
     if (config.pipeline == PipelineType::GPU) {
         return std::make_unique<GPUFluidSimulator>(config);
     }
-    return std::make_unique<FluidSimulator>(config);
+    return createFluidSimulator(config);
 }
 
-std::pair<int, int> mouseToGridCoords(const SDL_Event& event, int windowWidth, int windowHeight, ISimulator* simulator) {
+std::pair<int, int> mouseToGridCoords(const SDL_Event& event, int windowWidth, int windowHeight, const ISimulator* simulator) {
     int mouseX = event.motion.x;
     int mouseY = event.motion.y;
 
@@ -43,6 +46,13 @@ std::pair<int, int> mouseToGridCoords(const SDL_Event& event, int windowWidth, i
     return {gridX, gridY};
 }
 
+void printStageStats(const char* component, const std::vector<StageStats>& stats) {
+    for (const StageStats& stage : stats) {
+        std::printf("%-10s %-12s min %7.3f ms  mean %7.3f ms  p99 %7.3f ms  (%d samples)\n",
+                    component, stage.name.c_str(), stage.minMs, stage.meanMs, stage.p99Ms, stage.samples);
+    }
+}
+
 int main(int argc, char** argv) {
     // TODO support command line arguments for config file path
     Config config = ConfigLoader::loadConfig("../config.json");
@@ -156,33 +166,84 @@ int main(int argc, char** argv) {
 
     simulator->init(config, imageData);
 
+    // threaded: the simulator steps on its own thread and the loop below only handles
+    // input and draws the newest completed step; otherwise they alternate on this thread
+    std::unique_ptr<SimulationThread> simulationThread;
+    if (config.simulation.threaded) {
+        bool paced = config.pacing.mode != PacingMode::UNCAPPED;
+        simulationThread = std::make_unique<SimulationThread>(std::move(simulator), config.simulation.timestep, paced);
+        simulationThread->start();
+    }
+
     bool running = true;
     SDL_Event event;
+    int frame = 0;
+    FrameScheduler scheduler(config.pacing, config.simulation.timestep);
+    long long publishedSteps = 0;
 
     while (running) {
+        int steps = scheduler.beginFrame();
+        const ISimulator* state = simulator.get();
+        if (simulationThread) {
+            const FieldSnapshot& snapshot = simulationThread->latest();
+            scheduler.addSteps(snapshot.getStep() - publishedSteps);
+            publishedSteps = snapshot.getStep();
+            state = &snapshot;
+        }
+
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = false;
             } else if (event.type == SDL_MOUSEBUTTONDOWN and event.button.button == SDL_BUTTON_LEFT) {
-                std::pair<int, int> gridCoords = mouseToGridCoords(event, windowWidth, windowHeight, simulator.get());
-                if (simulator->isInsideCircle(gridCoords.first, gridCoords.second)) {
+                std::pair<int, int> gridCoords = mouseToGridCoords(event, windowWidth, windowHeight, state);
+                if (simulationThread) {
+                    simulationThread->onMouseDown(gridCoords.first, gridCoords.second);
+                } else if (simulator->isInsideCircle(gridCoords.first, gridCoords.second)) {
                     simulator->onMouseDown(gridCoords.first, gridCoords.second);
                 }
             } else if (event.type == SDL_MOUSEBUTTONUP and event.button.button == SDL_BUTTON_LEFT) {
-                simulator->onMouseUp();
+                if (simulationThread) {
+                    simulationThread->onMouseUp();
+                } else {
+                    simulator->onMouseUp();
+                }
             } else if (event.type == SDL_MOUSEMOTION and event.motion.state & SDL_BUTTON_LMASK) {
-                std::pair<int, int> gridCoords = mouseToGridCoords(event, windowWidth, windowHeight, simulator.get());
-                simulator->onMouseDrag(gridCoords.first, gridCoords.second);
+                std::pair<int, int> gridCoords = mouseToGridCoords(event, windowWidth, windowHeight, state);
+                if (simulationThread) {
+                    simulationThread->onMouseDrag(gridCoords.first, gridCoords.second);
+                } else {
+                    simulator->onMouseDrag(gridCoords.first, gridCoords.second);
+                }
+            }
+        }
+
+        if (!simulationThread) {
+            for (int n = 0; n < steps; n++) {
+                simulator->update();
             }
+            scheduler.addSteps(steps);
         }
+        renderer->render(*state);
 
-        simulator->update();
-        renderer->render(*simulator);
+        int reportInterval = config.profiling.reportInterval;
+        if (reportInterval > 0 && ++frame % reportInterval == 0) {
+            printStageStats("simulator", state->getStageStats());
+            printStageStats("renderer", renderer->getStageStats());
+            std::printf("%-10s active tiles %.1f%%\n", "simulator", 100.0f * state->getActiveTileFraction());
+        }
+
+        if (scheduler.reportDue()) {
+            FrameScheduler::Rates rates = scheduler.getRates();
+            std::printf("%-10s %.1f steps/s  %.1f frames/s  %lld dropped frames  %lld dropped steps\n", "pacing",
+                        rates.stepsPerSecond, rates.framesPerSecond, rates.droppedFrames, rates.droppedSteps);
+        }
 
-        // 60 fps
-        SDL_Delay(16);
+        scheduler.endFrame();
     }
 
+    if (simulationThread) {
+        simulationThread->stop();
+    }
     renderer->cleanup();
     SDL_DestroyWindow(window);
 
@@ -0,0 +1,264 @@
+#include "multigrid.h"
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+
+// stop coarsening once either interior dimension would drop below this
+static const int MIN_COARSE_CELLS = 8;
+// red-black sweeps used as the direct solve on the coarsest level
+static const int COARSEST_ITERATIONS = 64;
+
+template <typename Real>
+BasicMultigridSolver<Real>::BasicMultigridSolver()
+    : cycle(1),
+      smoothingIterations(2)
+{
+}
+
+template <typename Real>
+void BasicMultigridSolver<Real>::init(const GridLayout& fineLayout, const GridTraversal& traversal, int cycle, int smoothingIterations) {
+    this->traversal = traversal;
+    this->cycle = std::max(1, cycle);
+    this->smoothingIterations = std::max(1, smoothingIterations);
+
+    levels.clear();
+
+    // every level keeps a one cell solid ring; coarse interior cell I covers fine
+    // interior cells 2I-1 and 2I, so coarse dimensions are ceil(interior / 2) + 2
+    int levelX = fineLayout.gridX;
+    int levelY = fineLayout.gridY;
+    while (true) {
+        Level level;
+        level.gridX = levelX;
+        level.gridY = levelY;
+        if (levels.empty()) {
+            level.layout = fineLayout;
+        } else {
+            level.layout.init(levelX, levelY);
+        }
+        int size = level.layout.size;
+        level.rStore.assign(size, 0.0f);
+        if (!levels.empty()) {
+            level.sStore.assign(size, 0.0f);
+            level.flagsStore.assign(size, 0);
+            level.rhsStore.assign(size, 0.0f);
+            level.qStore.assign(size, 0.0f);
+        }
+        levels.push_back(std::move(level));
+
+        int interiorX = levelX - 2;
+        int interiorY = levelY - 2;
+        if ((interiorX + 1) / 2 < MIN_COARSE_CELLS || (interiorY + 1) / 2 < MIN_COARSE_CELLS) break;
+        levelX = (interiorX + 1) / 2 + 2;
+        levelY = (interiorY + 1) / 2 + 2;
+    }
+
+    // level 0 gets the caller's flags in setCellFlags() and rhs and q in solve()
+    for (size_t l = 0; l < levels.size(); l++) {
+        Level& level = levels[l];
+        level.flags = l > 0 ? level.flagsStore.data() : nullptr;
+        level.rhs = l > 0 ? level.rhsStore.data() : nullptr;
+        level.q = l > 0 ? level.qStore.data() : nullptr;
+        level.r = level.rStore.data();
+    }
+}
+
+template <typename Real>
+void BasicMultigridSolver<Real>::setCellFlags(const uint8_t* flags) {
+    if (levels.empty()) return;
+    levels[0].flags = flags;
+
+    // obstacle-aware coarse masks
+    for (size_t l = 1; l < levels.size(); l++) {
+        restrictMask(static_cast<int>(l));
+    }
+}
+
+template <typename Real>
+int BasicMultigridSolver<Real>::solve(const Real* rhs, Real* q, Real tolerance, int maxCycles) {
+    residualHistory.clear();
+    if (levels.empty()) return 0;
+
+    Level& fine = levels[0];
+    fine.rhs = rhs;
+    fine.q = q;
+
+    Real residual = computeResidual(fine);
+    residualHistory.push_back(residual);
+
+    int cycles = 0;
+    while (residual > tolerance && cycles < maxCycles) {
+        runCycle(0);
+        residual = computeResidual(fine);
+        residualHistory.push_back(residual);
+        cycles++;
+    }
+
+    return cycles;
+}
+
+template <typename Real>
+void BasicMultigridSolver<Real>::runCycle(int level) {
+    Level& current = levels[level];
+
+    if (level == static_cast<int>(levels.size()) - 1) {
+        smooth(current, COARSEST_ITERATIONS);
+        return;
+    }
+
+    smooth(current, smoothingIterations);
+    computeResidual(current);
+    restrictResidual(level + 1);
+
+    // 1 recursion per level is a V-cycle, 2 is a W-cycle
+    for (int n = 0; n < cycle; n++) {
+        runCycle(level + 1);
+    }
+
+    prolongCorrection(level);
+    smooth(current, smoothingIterations);
+}
+
+template <typename Real>
+void BasicMultigridSolver<Real>::smooth(Level& level, int iterations) {
+    const uint8_t* flags = level.flags;
+    const Real* rhs = level.rhs;
+    Real* q = level.q;
+    const GridLayout layout = level.layout;
+    const int stride = layout.stride;
+
+    // red-black Gauss-Seidel; cells of one color don't neighbor each other
+    const CellRange interior = {1, level.gridX - 1, 1, level.gridY - 1};
+    #pragma omp parallel
+    for (int n = 0; n < iterations; n++) {
+        for (int color = 0; color < 2; color++) {
+            traversal.forEachRowInParallel(interior, [=](int j, int iBegin, int iEnd) {
+                const int row = layout.idx(0, j);
+                for (int i = firstOfColor(iBegin, j, color); i < iEnd; i += 2) {
+                    int c = row + i;
+                    uint8_t f = flags[c];
+                    if (!(f & CELL_FLUID)) continue;
+
+                    Real sx0 = cellCoeff(f, CELL_XP);
+                    Real sx1 = cellCoeff(f, CELL_XM);
+                    Real sy0 = cellCoeff(f, CELL_YP);
+                    Real sy1 = cellCoeff(f, CELL_YM);
+                    Real b = sx0 + sx1 + sy0 + sy1;
+                    if (b == 0.0f) continue;
+
+                    q[c] = (rhs[c] + sx0 * q[c + 1] + sx1 * q[c - 1]
+                                   + sy0 * q[c + stride] + sy1 * q[c - stride]) / b;
+                }
+            });
+        }
+    }
+}
+
+template <typename Real>
+Real BasicMultigridSolver<Real>::computeResidual(Level& level) {
+    const uint8_t* flags = level.flags;
+    const Real* rhs = level.rhs;
+    const Real* q = level.q;
+    Real* r = level.r;
+    const GridLayout layout = level.layout;
+    const int stride = layout.stride;
+    const int gridX = level.gridX;
+    const int gridY = level.gridY;
+
+    return traversal.maxOverRows({0, gridX, 0, gridY}, [=](int j, int iBegin, int iEnd) {
+        const int row = layout.idx(0, j);
+        Real maxResidual = 0.0f;
+        for (int i = iBegin; i < iEnd; i++) {
+            int c = row + i;
+            uint8_t f = flags[c];
+            if (i == 0 || j == 0 || i == gridX - 1 || j == gridY - 1 || !(f & CELL_FLUID)) {
+                r[c] = 0.0f;
+                continue;
+            }
+
+            Real sx0 = cellCoeff(f, CELL_XP);
+            Real sx1 = cellCoeff(f, CELL_XM);
+            Real sy0 = cellCoeff(f, CELL_YP);
+            Real sy1 = cellCoeff(f, CELL_YM);
+            Real b = sx0 + sx1 + sy0 + sy1;
+
+            Real lq = b * q[c] - sx0 * q[c + 1] - sx1 * q[c - 1]
+                                - sy0 * q[c + stride] - sy1 * q[c - stride];
+            r[c] = b == 0.0f ? 0.0f : rhs[c] - lq;
+            maxResidual = std::max(maxResidual, std::fabs(r[c]));
+        }
+        return maxResidual;
+    });
+}
+
+template <typename Real>
+void BasicMultigridSolver<Real>::restrictMask(int level) {
+    const Level& fine = levels[level - 1];
+    Level& coarse = levels[level];
+
+    // a coarse cell is fluid if any of its fine children is fluid, so no residual is dropped.
+    // fluid edge cells (outflows) are never relaxed and hold zero pressure; a coarse edge
+    // cell covers the fine edge cells along its interior neighbor, corners stay solid
+    traversal.forEachRow({0, coarse.gridX, 0, coarse.gridY}, [&](int J, int IBegin, int IEnd) {
+        int jEdge = J == 0 ? 0 : J == coarse.gridY - 1 ? fine.gridY - 1 : -1;
+        int jBegin = jEdge >= 0 ? jEdge : 2 * J - 1;
+        int jEnd = jEdge >= 0 ? jEdge : std::min(2 * J, fine.gridY - 2);
+        for (int I = IBegin; I < IEnd; I++) {
+            int iEdge = I == 0 ? 0 : I == coarse.gridX - 1 ? fine.gridX - 1 : -1;
+            int iBegin = iEdge >= 0 ? iEdge : 2 * I - 1;
+            int iEnd = iEdge >= 0 ? iEdge : std::min(2 * I, fine.gridX - 2);
+
+            Real fluid = 0.0f;
+            if (iEdge < 0 || jEdge < 0) {
+                for (int j = jBegin; j <= jEnd; j++) {
+                    for (int i = iBegin; i <= iEnd; i++) {
+                        if (fine.flags[fine.idx(i, j)] & CELL_FLUID) fluid = 1.0f;
+                    }
+                }
+            }
+            coarse.sStore[coarse.idx(I, J)] = fluid;
+        }
+    });
+
+    buildCellFlags(coarse.sStore.data(), coarse.layout, coarse.flagsStore.data());
+}
+
+template <typename Real>
+void BasicMultigridSolver<Real>::restrictResidual(int level) {
+    const Level& fine = levels[level - 1];
+    Level& coarse = levels[level];
+
+    // summing the children matches the 4x larger coarse-cell Laplacian, so the coarse
+    // operator keeps the same unscaled stencil as the fine one
+    traversal.forEachRow({0, coarse.gridX, 0, coarse.gridY}, [&](int J, int IBegin, int IEnd) {
+        for (int I = IBegin; I < IEnd; I++) {
+            Real sum = 0.0f;
+            if (I > 0 && J > 0 && I < coarse.gridX - 1 && J < coarse.gridY - 1) {
+                for (int j = 2 * J - 1; j <= std::min(2 * J, fine.gridY - 2); j++) {
+                    for (int i = 2 * I - 1; i <= std::min(2 * I, fine.gridX - 2); i++) {
+                        sum += fine.r[fine.idx(i, j)];
+                    }
+                }
+            }
+            coarse.rhsStore[coarse.idx(I, J)] = sum;
+            coarse.qStore[coarse.idx(I, J)] = 0.0f;
+        }
+    });
+}
+
+template <typename Real>
+void BasicMultigridSolver<Real>::prolongCorrection(int level) {
+    Level& fine = levels[level];
+    const Level& coarse = levels[level + 1];
+
+    traversal.forEachRow({1, fine.gridX - 1, 1, fine.gridY - 1}, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            int c = fine.idx(i, j);
+            if (!(fine.flags[c] & CELL_FLUID)) continue;
+            fine.q[c] += coarse.q[coarse.idx((i + 1) / 2, (j + 1) / 2)];
+        }
+    });
+}
+
+template class BasicMultigridSolver<float>;
+template class BasicMultigridSolver<double>;
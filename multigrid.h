@@ -0,0 +1,63 @@
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include <vector>
+#include "cell_flags.h"
+#include "grid_traversal.h"
+
+// geometric multigrid for the cell-centered pressure problem L q = rhs, where L is
+// the 5-point Laplacian restricted to fluid cells. Real is the simulator's scalar type
+// (instantiated for float and double in multigrid.cpp)
+template <typename Real>
+class BasicMultigridSolver {
+public:
+    BasicMultigridSolver();
+
+    // builds the level hierarchy; call once when the grid size changes. the fine level
+    // uses the caller's layout, coarse levels get their own padded layouts; every level
+    // is walked with the caller's traversal
+    void init(const GridLayout& fineLayout, const GridTraversal& traversal, int cycle, int smoothingIterations);
+
+    // fine-level stencil flags; coarse masks are only re-restricted when obstacles change
+    void setCellFlags(const uint8_t* flags);
+
+    // returns the number of cycles used; q is used as the initial guess
+    int solve(const Real* rhs, Real* q, Real tolerance, int maxCycles);
+
+    // max residual before the first cycle and after each cycle of the last solve
+    const std::vector<Real>& getResidualHistory() const { return residualHistory; }
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+
+private:
+    struct Level {
+        int gridX, gridY;
+        GridLayout layout;
+
+        // level 0 points at the caller's buffers, coarser levels at their own storage
+        const uint8_t* flags;
+        const Real* rhs;
+        Real* q;
+        Real* r;
+        std::vector<Real> sStore, rhsStore, qStore, rStore; // sStore: restricted solid field
+        std::vector<uint8_t> flagsStore;
+
+        int idx(int i, int j) const { return layout.idx(i, j); }
+    };
+
+    std::vector<Level> levels;
+    std::vector<Real> residualHistory;
+    GridTraversal traversal;
+    int cycle; // 1=V-cycle, 2=W-cycle
+    int smoothingIterations;
+
+    void runCycle(int level);
+    void smooth(Level& level, int iterations);
+    Real computeResidual(Level& level);
+    void restrictMask(int level);
+    void restrictResidual(int level);
+    void prolongCorrection(int level);
+};
+
+typedef BasicMultigridSolver<float> MultigridSolver;
+
+#endif
@@ -0,0 +1,62 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+
+StageProfiler::StageProfiler(std::initializer_list<const char*> stageNames)
+    : enabled(true)
+{
+    for (const char* name : stageNames) {
+        stages.push_back({name, std::vector<float>(WINDOW, 0.0f), 0, 0, 0, 0.0});
+    }
+}
+
+void StageProfiler::record(int stage, float ms) {
+    Stage& s = stages[stage];
+    s.samples[s.next] = ms;
+    s.next = (s.next + 1) % WINDOW;
+    s.count = std::min(s.count + 1, WINDOW);
+    s.calls++;
+    s.totalMs += ms;
+}
+
+void StageProfiler::reset() {
+    for (Stage& s : stages) {
+        s.count = 0;
+        s.next = 0;
+        s.calls = 0;
+        s.totalMs = 0.0;
+    }
+}
+
+std::vector<StageStats> StageProfiler::getStats() const {
+    std::vector<StageStats> result;
+    result.reserve(stages.size());
+
+    std::vector<float> sorted;
+    for (const Stage& s : stages) {
+        StageStats stats;
+        stats.name = s.name;
+        stats.samples = s.count;
+        stats.calls = s.calls;
+        stats.totalMs = s.totalMs;
+
+        if (s.count > 0) {
+            // the window is full once count == WINDOW, otherwise it's the first count slots
+            sorted.assign(s.samples.begin(), s.samples.begin() + s.count);
+            std::sort(sorted.begin(), sorted.end());
+
+            double sum = 0.0;
+            for (float ms : sorted) sum += ms;
+
+            int p99Index = std::min(s.count - 1, static_cast<int>(std::ceil(0.99 * s.count)) - 1);
+            stats.lastMs = s.samples[(s.next + WINDOW - 1) % WINDOW];
+            stats.minMs = sorted.front();
+            stats.meanMs = static_cast<float>(sum / s.count);
+            stats.p99Ms = sorted[std::max(0, p99Index)];
+        }
+
+        result.push_back(stats);
+    }
+
+    return result;
+}
@@ -0,0 +1,81 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// rolling timing stats for one stage, in milliseconds
+struct StageStats {
+    std::string name;
+    int samples = 0; // samples in the window
+    long long calls = 0; // all samples since the last reset
+    double totalMs = 0.0;
+    float lastMs = 0.0f;
+    float minMs = 0.0f;
+    float meanMs = 0.0f;
+    float p99Ms = 0.0f;
+};
+
+// per-stage wall clock timings over a rolling window of recent frames
+class StageProfiler {
+public:
+    static constexpr int WINDOW = 256; // ~4 s at 60 fps
+
+    StageProfiler(std::initializer_list<const char*> stageNames);
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    void record(int stage, float ms);
+    void reset();
+
+    // computed on demand; recording only writes into the ring buffer
+    std::vector<StageStats> getStats() const;
+
+private:
+    struct Stage {
+        const char* name;
+        std::vector<float> samples; // ring buffer
+        int count;
+        int next;
+        long long calls;
+        double totalMs;
+    };
+    std::vector<Stage> stages;
+    bool enabled;
+};
+
+// times the enclosing scope; does nothing (no clock reads) while the profiler is disabled
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(StageProfiler& profiler, int stage)
+        : profiler(profiler.isEnabled() ? &profiler : nullptr), stage(stage) {
+        if (this->profiler) start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedStageTimer() {
+        if (!profiler) return;
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        profiler->record(stage, elapsed.count());
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    StageProfiler* profiler;
+    int stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+// KATARA_PROFILING is set by the build (on by default); without it stage timers compile to nothing
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifdef KATARA_PROFILING
+#define PROFILE_STAGE(profiler, stage) ScopedStageTimer PROFILE_CONCAT(stageTimer, __LINE__)(profiler, stage)
+#else
+#define PROFILE_STAGE(profiler, stage) ((void)0)
+#endif
+
+#endif
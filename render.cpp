@@ -24,8 +24,11 @@ Renderer::Renderer(SDL_Window* window, const Config& config)
     densityHistogramMax(0.0f),
     velocityHistogramBins(IRenderer::HISTOGRAM_BINS, 0),
     velocityHistogramMin(0.0f),
-    velocityHistogramMax(0.0f)
+    velocityHistogramMax(0.0f),
+
+    profiler({"frame", "draw", "histograms", "upload", "present"})
 {
+    profiler.setEnabled(config.profiling.enabled);
     SDL_GetWindowSize(window, &windowWidth, &windowHeight);
 
     // world coordinates set after simulator is available
@@ -43,7 +46,11 @@ Renderer::~Renderer() {
 }
 
 bool Renderer::init(const Config& config) {
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 flags = SDL_RENDERER_ACCELERATED;
+    if (config.pacing.mode == PacingMode::VSYNC) {
+        flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    renderer = SDL_CreateRenderer(window, -1, flags);
     if (!renderer) {
         return false;
     }
@@ -69,34 +76,47 @@ void Renderer::cleanup() {
 }
 
 void Renderer::render(const ISimulator& simulator) {
+    PROFILE_STAGE(profiler, STAGE_FRAME);
     simWidth = simulator.getDomainWidth();
     simHeight = simulator.getDomainHeight();
     float scaleX = windowWidth / simWidth;
     float scaleY = windowHeight / simHeight;
     canvasScale = std::min(scaleX, scaleY);
 
-    // clear bg
-    std::fill(pixels, pixels + windowWidth * windowHeight, 0xFF000000);
+    {
+        PROFILE_STAGE(profiler, STAGE_DRAW);
 
-    drawFluidField(simulator);
-    if (drawVelocities) {
-        drawVelocityField(simulator);
-    }
+        // clear bg
+        std::fill(pixels, pixels + windowWidth * windowHeight, 0xFF000000);
 
-    // compute histograms every n frames
-    int histogramFrameInterval = 1;
-    if (!disableHistograms && frameCount++ % histogramFrameInterval == 0) {
-        computeHistograms(simulator);
+        drawFluidField(simulator);
+        if (drawVelocities) {
+            drawVelocityField(simulator);
+        }
     }
 
-    // draw histograms every frame
-    if (!disableHistograms) {
-        drawHistograms();
+    {
+        PROFILE_STAGE(profiler, STAGE_HISTOGRAMS);
+
+        // compute histograms every n frames
+        int histogramFrameInterval = 1;
+        if (!disableHistograms && frameCount++ % histogramFrameInterval == 0) {
+            computeHistograms(simulator);
+        }
+
+        // draw histograms every frame
+        if (!disableHistograms) {
+            drawHistograms();
+        }
     }
 
-    SDL_UpdateTexture(texture, nullptr, pixels, windowWidth * sizeof(Uint32));
+    {
+        PROFILE_STAGE(profiler, STAGE_UPLOAD);
+        SDL_UpdateTexture(texture, nullptr, pixels, windowWidth * sizeof(Uint32));
+    }
 
     // render to screen
+    PROFILE_STAGE(profiler, STAGE_PRESENT);
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, nullptr, nullptr);
     SDL_RenderPresent(renderer);
@@ -179,31 +199,33 @@ void Renderer::drawFluidField(const ISimulator& simulator) {
     float cellSize = simulator.getCellSize();
     int gridX = simulator.getGridX();
     int gridY = simulator.getGridY();
+    int stride = simulator.getFieldStride();
+    int offset = simulator.getFieldOffset();
 
     // pressure range
-    float minP = pressure[0];
-    float maxP = pressure[0];
-    for (int i = 0; i < gridX * gridY; i++) {
-        minP = std::min(minP, pressure[i]);
-        maxP = std::max(maxP, pressure[i]);
-    }
+    float minP = 0.0f;
+    float maxP = 0.0f;
+    fieldRange(pressure, minP, maxP);
+
+    // vorticity range, symmetric so zero curl maps to the middle of the colormap
+    const auto& vorticity = simulator.getVorticity();
+    bool drawVorticity = drawTarget == 4 && vorticity.size() == pressure.size();
+    float maxW = drawVorticity ? maxMagnitude(vorticity) : 0.0f;
 
     // get ink references if needed
     bool inkInitialized = false;
-    const std::vector<float>* r_ink_ptr = nullptr;
-    const std::vector<float>* g_ink_ptr = nullptr;
-    const std::vector<float>* b_ink_ptr = nullptr;
+    FieldView redInk, greenInk, blueInk;
     if (drawTarget == 3 && simulator.isInkInitialized()) {
-        r_ink_ptr = &simulator.getRedInk();
-        g_ink_ptr = &simulator.getGreenInk();
-        b_ink_ptr = &simulator.getBlueInk();
+        redInk = simulator.getRedInk();
+        greenInk = simulator.getGreenInk();
+        blueInk = simulator.getBlueInk();
         inkInitialized = true;
     }
 
     // draw cells
     for (int i = 0; i < gridX; i++) {
         for (int j = 0; j < gridY; j++) {
-            int idx = j * gridX + i;
+            int idx = offset + j * stride + i;
 
             if (solid[idx] != 0.0f) {
                 Uint8 r, g, b;
@@ -214,10 +236,13 @@ void Renderer::drawFluidField(const ISimulator& simulator) {
                 } else if (drawTarget == 1) {
                     // draw smoke/density
                     mapValueToGreyscale(density[idx], 0.0f, 1.0f, r, g, b);
+                } else if (drawVorticity) {
+                    // draw curl: blue clockwise, red counterclockwise
+                    mapValueToColor(vorticity[idx], -maxW, maxW, r, g, b);
                 } else if (drawTarget == 3) {
                     // draw ink diffusion
-                    if (inkInitialized && r_ink_ptr->size() > idx) {
-                        mapInkToColor((*r_ink_ptr)[idx], (*g_ink_ptr)[idx], (*b_ink_ptr)[idx], r, g, b);
+                    if (inkInitialized && redInk.size() > static_cast<size_t>(idx)) {
+                        mapInkToColor(redInk[idx], greenInk[idx], blueInk[idx], r, g, b);
                     } else {
                         // default to white
                         r = 255; g = 255; b = 255;
@@ -272,13 +297,15 @@ void Renderer::drawVelocityField(const ISimulator& simulator) {
     float cellSize = simulator.getCellSize();
     int gridX = simulator.getGridX();
     int gridY = simulator.getGridY();
+    int stride = simulator.getFieldStride();
+    int offset = simulator.getFieldOffset();
 
     float VELOCITY_VECTOR_LENGTH = 0.3f;
 
     // velocity vectors in white (normalized to unit length, then scaled)
     for (int i = 0; i < gridX; i++) {
         for (int j = 0; j < gridY; j++) {
-            int idx = j * gridX + i;
+            int idx = offset + j * stride + i;
 
             if (solid[idx] != 0.0f) {
                 float vx = velocityX[idx];
@@ -16,6 +16,7 @@ public:
     bool init(const Config& config) override;
     void cleanup() override;
     void render(const ISimulator& simulator) override;
+    std::vector<StageStats> getStageStats() const override { return profiler.getStats(); }
 
 private:
     SDL_Window* window;
@@ -28,7 +29,7 @@ private:
     float simWidth, simHeight;
 
     // draw params
-    int drawTarget; // 0=pressure, 1=smoke, 2=both
+    int drawTarget; // 0=pressure, 1=smoke, 2=both, 3=ink, 4=vorticity
     bool drawVelocities;
     bool disableHistograms;
     float velScale;
@@ -40,6 +41,10 @@ private:
     std::vector<int> velocityHistogramBins;
     float velocityHistogramMin, velocityHistogramMax;
 
+    // stage timings of render(), indexed by Stage
+    enum Stage { STAGE_FRAME, STAGE_DRAW, STAGE_HISTOGRAMS, STAGE_UPLOAD, STAGE_PRESENT };
+    StageProfiler profiler;
+
     // draw utils
     void convertCoordinates(float simX, float simY, int& pixelX, int& pixelY);
     void mapValueToColor(float value, float min, float max, Uint8& r, Uint8& g, Uint8& b);
@@ -0,0 +1,159 @@
+// microbenchmark: per-sample cost of the runtime-switch sampler that used to live in
+// FluidSimulator::sample(float, float, int) vs the staggering-templated GridSampler
+//
+// build: g++ -O2 -std=c++17 sample_bench.cpp -o sample_bench (or the sample_bench target)
+// usage: ./sample_bench [gridX] [gridY] [samples]
+
+#include "sampler.h"
+#include "grid_layout.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// previous implementation, kept here as the baseline
+struct SwitchSampler {
+    int gridX, gridY;
+    float cellHeight, halfCellHeight, xHeight, yHeight;
+    const std::vector<float>* fields[3];
+
+    float clamp(float n, float min, float max) const {
+        return std::min(max, std::max(min, n));
+    }
+
+    float sample(float i, float j, int type) const {
+        i = clamp(i, cellHeight, xHeight);
+        j = clamp(j, cellHeight, yHeight);
+
+        float xOffset = 0.0f;
+        float yOffset = 0.0f;
+
+        const std::vector<float>* field = nullptr;
+        switch (type) {
+            case 0:
+                field = fields[0];
+                yOffset = halfCellHeight;
+                break;
+            case 1:
+                field = fields[1];
+                xOffset = halfCellHeight;
+                break;
+            case 2:
+                field = fields[2];
+                xOffset = halfCellHeight;
+                yOffset = halfCellHeight;
+                break;
+            default:
+                return 0.0f;
+        }
+
+        int x0 = std::min(static_cast<int>(floor((i-xOffset) / cellHeight)), gridX-1);
+        int x1 = std::min(x0+1, gridX-1);
+
+        int y0 = std::min(static_cast<int>(floor((j-yOffset) / cellHeight)), gridY-1);
+        int y1 = std::min(y0+1, gridY-1);
+
+        float tx = ((i-xOffset) - x0*cellHeight) / cellHeight;
+        float ty = ((j-yOffset) - y0*cellHeight) / cellHeight;
+
+        float sx = 1.0f - tx;
+        float sy = 1.0f - ty;
+
+        return sx * sy * (*field)[y0 * gridX + x0] +
+               tx * sy * (*field)[y0 * gridX + x1] +
+               tx * ty * (*field)[y1 * gridX + x1] +
+               sx * ty * (*field)[y1 * gridX + x0];
+    }
+};
+
+template <typename F>
+double nsPerSample(F&& run, int samples, float& sink) {
+    auto start = std::chrono::steady_clock::now();
+    sink += run();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / samples;
+}
+
+int main(int argc, char** argv) {
+    int gridX = argc > 1 ? std::atoi(argv[1]) : 600;
+    int gridY = argc > 2 ? std::atoi(argv[2]) : 400;
+    int samples = argc > 3 ? std::atoi(argv[3]) : 1 << 22;
+    const int repeats = 5;
+
+    float cellHeight = 1.0f / gridY;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<float> u(gridX * gridY), v(gridX * gridY), d(gridX * gridY);
+    for (int k = 0; k < gridX * gridY; k++) {
+        u[k] = value(rng);
+        v[k] = value(rng);
+        d[k] = value(rng);
+    }
+
+    // backtraced positions are near the cell they start from, so walk the grid
+    // in order with small jitter like advect() does
+    std::vector<float> px(samples), py(samples);
+    for (int k = 0; k < samples; k++) {
+        int cell = k % (gridX * gridY);
+        px[k] = (cell % gridX + 0.5f + value(rng)) * cellHeight;
+        py[k] = (cell / gridX + 0.5f + value(rng)) * cellHeight;
+    }
+
+    SwitchSampler before = { gridX, gridY, cellHeight, cellHeight / 2.0f, cellHeight * gridX, cellHeight * gridY, { &u, &v, &d } };
+    // GridSampler reads the simulator's padded layout
+    GridLayout layout;
+    layout.init(gridX, gridY);
+    std::vector<float> uPadded(layout.size, 0.0f), vPadded(layout.size, 0.0f), dPadded(layout.size, 0.0f);
+    for (int j = 0; j < gridY; j++) {
+        for (int i = 0; i < gridX; i++) {
+            uPadded[layout.idx(i, j)] = u[j * gridX + i];
+            vPadded[layout.idx(i, j)] = v[j * gridX + i];
+            dPadded[layout.idx(i, j)] = d[j * gridX + i];
+        }
+    }
+
+    GridSampler after;
+    after.stride = layout.stride;
+    after.origin = layout.origin;
+    after.cellHeight = cellHeight;
+    after.xHeight = cellHeight * gridX;
+    after.yHeight = cellHeight * gridY;
+
+    // keep the field type opaque to the compiler, as in advect() where it came from a call site
+    volatile int typeU = 0, typeV = 1, typeD = 2;
+
+    float sink = 0.0f;
+    double bestBefore = 1e30, bestAfter = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        bestBefore = std::min(bestBefore, nsPerSample([&] {
+            float sum = 0.0f;
+            int tu = typeU, tv = typeV, td = typeD;
+            for (int k = 0; k < samples; k++) {
+                sum += before.sample(px[k], py[k], tu) + before.sample(px[k], py[k], tv) + before.sample(px[k], py[k], td);
+            }
+            return sum;
+        }, samples * 3, sink));
+
+        bestAfter = std::min(bestAfter, nsPerSample([&] {
+            float sum = 0.0f;
+            const float* uField = uPadded.data();
+            const float* vField = vPadded.data();
+            const float* dField = dPadded.data();
+            for (int k = 0; k < samples; k++) {
+                sum += after.sample<Staggering::U_FACE>(uField, px[k], py[k]) +
+                       after.sample<Staggering::V_FACE>(vField, px[k], py[k]) +
+                       after.sample<Staggering::CELL_CENTER>(dField, px[k], py[k]);
+            }
+            return sum;
+        }, samples * 3, sink));
+    }
+
+    std::cout << "grid " << gridX << "x" << gridY << ", " << samples * 3 << " samples, best of " << repeats << std::endl;
+    std::cout << "switch sampler:    " << bestBefore << " ns/sample" << std::endl;
+    std::cout << "templated sampler: " << bestAfter << " ns/sample" << std::endl;
+    std::cout << "(checksum " << sink << ")" << std::endl;
+
+    return 0;
+}
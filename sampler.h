@@ -0,0 +1,97 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+
+// where a field's samples live within a cell
+enum class Staggering {
+    U_FACE, // x velocity, left face
+    V_FACE, // y velocity, bottom face
+    CELL_CENTER // density, ink
+};
+
+// sample offsets in cells, known at compile time
+template <Staggering S> struct StaggerOffset;
+template <> struct StaggerOffset<Staggering::U_FACE> {
+    static constexpr float x = 0.0f;
+    static constexpr float y = 0.5f;
+};
+template <> struct StaggerOffset<Staggering::V_FACE> {
+    static constexpr float x = 0.5f;
+    static constexpr float y = 0.0f;
+};
+template <> struct StaggerOffset<Staggering::CELL_CENTER> {
+    static constexpr float x = 0.5f;
+    static constexpr float y = 0.5f;
+};
+
+// bilinear sample location, reusable for every field with the same staggering
+template <typename Real>
+struct BasicSampleWeights {
+    int i00, i10, i01, i11;
+    Real w00, w10, w01, w11;
+};
+typedef BasicSampleWeights<float> SampleWeights;
+
+// bilinear sampling of padded grid fields (see grid_layout.h) in world coordinates;
+// x0+1 and y0+1 may land in the high ghost layers, which must hold the edge values
+template <typename Real>
+struct BasicGridSampler {
+    int stride = 0, origin = 0; // GridLayout addressing
+    Real cellHeight = 1.0f;
+    Real xHeight = 0.0f, yHeight = 0.0f; // domain extents
+
+    template <Staggering S>
+    BasicSampleWeights<Real> weights(Real i, Real j) const {
+        constexpr Real xOffsetCells = StaggerOffset<S>::x;
+        constexpr Real yOffsetCells = StaggerOffset<S>::y;
+        const Real xOffset = xOffsetCells * cellHeight;
+        const Real yOffset = yOffsetCells * cellHeight;
+
+        i = std::min(xHeight, std::max(cellHeight, i));
+        j = std::min(yHeight, std::max(cellHeight, j));
+
+        // clamped positions are at least half a cell from the origin, so truncation is floor;
+        // at most gridX (gridY) at the far edge, so x1 (y1) reaches the second ghost layer
+        int x0 = static_cast<int>((i-xOffset) / cellHeight);
+        int x1 = x0+1;
+
+        int y0 = static_cast<int>((j-yOffset) / cellHeight);
+        int y1 = y0+1;
+
+        Real tx = ((i-xOffset) - x0*cellHeight) / cellHeight;
+        Real ty = ((j-yOffset) - y0*cellHeight) / cellHeight;
+
+        Real sx = 1.0f - tx;
+        Real sy = 1.0f - ty;
+
+        BasicSampleWeights<Real> w;
+        int row0 = origin + y0 * stride;
+        int row1 = origin + y1 * stride;
+        w.i00 = row0 + x0;
+        w.i10 = row0 + x1;
+        w.i01 = row1 + x0;
+        w.i11 = row1 + x1;
+        w.w00 = sx * sy;
+        w.w10 = tx * sy;
+        w.w01 = sx * ty;
+        w.w11 = tx * ty;
+        return w;
+    }
+
+    static Real interpolate(const Real* field, const BasicSampleWeights<Real>& w) {
+        return w.w00 * field[w.i00] +
+               w.w10 * field[w.i10] +
+               w.w11 * field[w.i11] +
+               w.w01 * field[w.i01];
+    }
+
+    template <Staggering S>
+    Real sample(const Real* field, Real i, Real j) const {
+        return interpolate(field, weights<S>(i, j));
+    }
+};
+typedef BasicGridSampler<float> GridSampler;
+
+#endif
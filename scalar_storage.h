@@ -0,0 +1,133 @@
+#ifndef SCALAR_STORAGE_H
+#define SCALAR_STORAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// storage format of the passive scalar fields (density, ink); all arithmetic on them
+// is fp32, values are converted on load and rounded to nearest even on store
+enum class ScalarPrecision {
+    FP32,
+    FP16, // IEEE half: 10 bit mantissa, max 65504
+    BF16 // bfloat16: fp32 range, 7 bit mantissa
+};
+
+inline size_t scalarPrecisionBytes(ScalarPrecision precision) {
+    return precision == ScalarPrecision::FP32 ? sizeof(float) : sizeof(uint16_t);
+}
+
+// 16 bit storage element types, distinct so kernels can overload on them
+struct Half { uint16_t bits; };
+struct BFloat16 { uint16_t bits; };
+
+inline uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bitsToFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// same results as the F16C instructions (round to nearest even, quiet NaNs), so the
+// scalar and vector advection kernels stay bit-identical
+inline uint16_t floatToHalfBits(float value) {
+    uint32_t bits = floatBits(value);
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+    if (magnitude > 0x7F800000u) {
+        return static_cast<uint16_t>(sign | 0x7E00u | ((magnitude >> 13) & 0x3FFu));
+    }
+    if (magnitude >= 0x47800000u) { // 65536 and up, inf
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (magnitude < 0x38800000u) {
+        // half subnormal or zero: adding 0.5 lines the half mantissa up with the low
+        // float mantissa bits and lets the FPU round
+        const uint32_t magic = 0x3F000000u;
+        uint32_t rounded = floatBits(bitsToFloat(magnitude) + bitsToFloat(magic)) - magic;
+        return static_cast<uint16_t>(sign | rounded);
+    }
+    // rebias the exponent, round to nearest even; a mantissa carry bumps the exponent,
+    // up to inf for values in [65520, 65536)
+    uint32_t odd = (magnitude >> 13) & 1u;
+    magnitude += 0xC8000FFFu + odd;
+    return static_cast<uint16_t>(sign | (magnitude >> 13));
+}
+
+inline float halfBitsToFloat(uint16_t half) {
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+
+    if (exponent == 0x1Fu) {
+        return bitsToFloat(sign | 0x7F800000u | (mantissa << 13) | (mantissa ? 0x400000u : 0u));
+    }
+    if (exponent == 0) {
+        // subnormal: exact in fp32
+        float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8f; // 2^-24
+        return bitsToFloat(sign | floatBits(magnitude));
+    }
+    return bitsToFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+// round to nearest even on the upper 16 bits; NaNs are kept quiet instead of rounded
+inline uint16_t floatToBFloat16Bits(float value) {
+    uint32_t bits = floatBits(value);
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+        return static_cast<uint16_t>((bits | 0x400000u) >> 16);
+    }
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    return static_cast<uint16_t>(bits >> 16);
+}
+
+inline float bfloat16BitsToFloat(uint16_t value) {
+    return bitsToFloat(static_cast<uint32_t>(value) << 16);
+}
+
+inline float toFloat(float value) { return value; }
+inline float toFloat(Half value) { return halfBitsToFloat(value.bits); }
+inline float toFloat(BFloat16 value) { return bfloat16BitsToFloat(value.bits); }
+
+template <typename T> T fromFloat(float value);
+template <> inline float fromFloat<float>(float value) { return value; }
+template <> inline Half fromFloat<Half>(float value) { return {floatToHalfBits(value)}; }
+template <> inline BFloat16 fromFloat<BFloat16>(float value) { return {floatToBFloat16Bits(value)}; }
+
+// a scalar field of any precision, for code outside the hot loops; element k is
+// addressed like the float fields
+struct ScalarField {
+    void* data = nullptr;
+    ScalarPrecision precision = ScalarPrecision::FP32;
+
+    explicit operator bool() const { return data != nullptr; }
+
+    float get(size_t k) const {
+        switch (precision) {
+            case ScalarPrecision::FP16: return toFloat(static_cast<const Half*>(data)[k]);
+            case ScalarPrecision::BF16: return toFloat(static_cast<const BFloat16*>(data)[k]);
+            default: return static_cast<const float*>(data)[k];
+        }
+    }
+
+    void set(size_t k, float value) const {
+        switch (precision) {
+            case ScalarPrecision::FP16: static_cast<Half*>(data)[k] = fromFloat<Half>(value); break;
+            case ScalarPrecision::BF16: static_cast<BFloat16*>(data)[k] = fromFloat<BFloat16>(value); break;
+            default: static_cast<float*>(data)[k] = value; break;
+        }
+    }
+
+    void fill(size_t begin, size_t end, float value) const {
+        for (size_t k = begin; k < end; k++) {
+            set(k, value);
+        }
+    }
+};
+
+#endif
@@ -3,26 +3,65 @@
 #include <algorithm>
 #include <omp.h>
 #include <iostream>
-#include <SDL2/SDL.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 
-FluidSimulator::FluidSimulator(const Config& config)
+template <typename Real>
+BasicFluidSimulator<Real>::BasicFluidSimulator(const Config& config)
     :
     // sim params
     resolution(config.simulation.resolution), // grid cells per world unit
+    activityEnabled(config.simulation.activity.enabled),
+    activityTolerance(config.simulation.activity.tolerance),
+    activityTileSize(config.simulation.activity.tileSize),
+    wakeAllTiles(true),
     timeStep(config.simulation.timestep),
     gravity(config.simulation.gravity),
     density(config.simulation.fluidDensity),
+    projectionSolver(config.simulation.projection.solver),
     overrelaxationCoefficient(config.simulation.projection.overrelaxationCoefficient), // speeds up projection
     gsIterations(config.simulation.projection.iterations), // projection solver
+    projectionTolerance(config.simulation.projection.tolerance),
+    projectionMaxIterations(config.simulation.projection.maxIterations),
+    warmStart(config.simulation.projection.warmStart),
+    earlyExit(config.simulation.projection.earlyExit),
+    divergenceOffset(0.0f),
+    multigridCycle(config.simulation.projection.multigridCycle),
+    smoothingIterations(config.simulation.projection.smoothingIterations),
+    blockDepth(std::max(1, config.simulation.projection.blockDepth)),
+    projectionIterations(0),
+    projectionResidual(0.0f),
     doVorticity(config.simulation.vorticity.enabled),
+    curlNeeded(config.simulation.vorticity.enabled || config.rendering.target == 4),
     vorticity(config.simulation.vorticity.strength),
     vorticityLen(config.simulation.vorticity.lengthScale),
+    simdLevel(config.simulation.simd),
+    advectRowKernel(advectRowScalar),
+    stepFunction(&BasicFluidSimulator::step<0>),
+    scalarPrecision(config.simulation.scalarPrecision),
 
     // wind tunnel state
     windTunnelStart(config.simulation.windTunnel.startPosition),
     windTunnelEnd(config.simulation.windTunnel.endPosition),
     windTunnelSide(config.simulation.windTunnel.side), // 0=left, 1=top, 2=bottom, 3=right, -1=disabled
     windTunnelVelocity(config.simulation.windTunnel.velocity),
+    hasOutflow(false),
+
+    // circle momentum transfer
+    momentumTransferCoeff(config.simulation.circle.momentumTransferCoeff),
+    momentumTransferRadius(config.simulation.circle.momentumTransferRadius),
+
+    // field storage
+    hugePages(config.simulation.hugePages),
+
+    obstaclesDirty({0, 0, 0, 0}),
+
+    // ink state
+    inkInitialized(false),
+
+    profiler({"step", "integrate", "project", "extrapolate", "activity", "advect", "vorticity"}),
 
     // circle state
     circleX(0),
@@ -35,19 +74,20 @@ FluidSimulator::FluidSimulator(const Config& config)
 
     // mouse state
     isDragging(false),
-
-    // circle momentum transfer
-    momentumTransferCoeff(config.simulation.circle.momentumTransferCoeff),
-    momentumTransferRadius(config.simulation.circle.momentumTransferRadius),
-
-    // ink state
-    inkInitialized(false)
+    circleMovePending(false),
+    targetCircleX(0),
+    targetCircleY(0)
 {
+    profiler.setEnabled(config.profiling.enabled);
+    traversal.setTileSize(config.simulation.traversal.tileRows, config.simulation.traversal.tileCols);
+    bindFields(); // no fields until init()
 }
 
-FluidSimulator::~FluidSimulator() {}
+template <typename Real>
+BasicFluidSimulator<Real>::~BasicFluidSimulator() {}
 
-void FluidSimulator::init(const Config& config, const ImageData* imageData) {
+template <typename Real>
+void BasicFluidSimulator<Real>::init(const Config& config, const ImageData* imageData) {
     bool imageLoaded = (imageData != nullptr && imageData->pixels != nullptr);
 
     if (imageLoaded) {
@@ -63,56 +103,116 @@ void FluidSimulator::init(const Config& config, const ImageData* imageData) {
         domainHeight = 1.0f;
         domainWidth = 1.5f;
     }
-    cellHeight = domainHeight / resolution;
+    cellHeight = static_cast<Real>(domainHeight) / resolution;
     halfCellHeight = cellHeight / 2.0f;
 
-    gridX = static_cast<int>(domainWidth / cellHeight);
-    gridY = static_cast<int>(domainHeight / cellHeight);
+    // grid size from the float cell size, so float and double runs use the same grid
+    float cellSize = domainHeight / resolution;
+    gridX = static_cast<int>(domainWidth / cellSize);
+    gridY = static_cast<int>(domainHeight / cellSize);
     xHeight = cellHeight * gridX;
     yHeight = cellHeight * gridY;
 
+    layout.init(gridX, gridY);
+    sampler.stride = layout.stride;
+    sampler.origin = layout.origin;
+    sampler.cellHeight = cellHeight;
+    sampler.xHeight = xHeight;
+    sampler.yHeight = yHeight;
+
     pipeHeight = static_cast<int>(0.1f * gridY);
     pressureMultiplier = density * cellHeight / timeStep;
 
-    int totalCells = gridX * gridY;
-
-    // simulator fields
-    x.resize(totalCells);
-    y.resize(totalCells);
-    s.resize(totalCells);
-    p.resize(totalCells);
-    d.resize(totalCells);
-    newX.resize(totalCells);
-    newY.resize(totalCells);
-    newD.resize(totalCells);
-    new_r_ink.resize(totalCells);
-    new_g_ink.resize(totalCells);
-    new_b_ink.resize(totalCells);
-
-    std::fill(s.begin(), s.end(), 1.0f);
-    std::fill(d.begin(), d.end(), 1.0f);
-    std::fill(p.begin(), p.end(), 0.0f);
-    std::fill(x.begin(), x.end(), 0.0f);
-    std::fill(y.begin(), y.end(), 0.0f);
+    // every field, including the solver scratch arrays, uses the padded layout and
+    // lives in one arena; back buffers of passive scalars only need a handle
+    arena.clear();
+    xField = arena.addField("x", sizeof(Real));
+    yField = arena.addField("y", sizeof(Real));
+    newXField = arena.addField("newX", sizeof(Real));
+    newYField = arena.addField("newY", sizeof(Real));
+    sField = arena.addField("s", sizeof(Real));
+    flagsField = arena.addField("cellFlags", sizeof(uint8_t));
+    pField = arena.addField("p", sizeof(Real));
+    dField = arena.addScalarField("d", scalarPrecision);
+    FieldHandle newDField = arena.addScalarField("newD", scalarPrecision);
+    wField = arena.addField("w", sizeof(Real));
+
+    // PCG/multigrid solver fields
+    bool needsCorrection = projectionSolver == ProjectionSolver::PCG ||
+                           projectionSolver == ProjectionSolver::MULTIGRID || warmStart;
+    correctionField = needsCorrection ? arena.addField("solverCorrection", sizeof(Real)) : INVALID_FIELD;
+    residualField = needsCorrection ? arena.addField("solverResidual", sizeof(Real)) : INVALID_FIELD;
+    bool pcg = projectionSolver == ProjectionSolver::PCG;
+    pcgAuxField = pcg ? arena.addField("pcgAux", sizeof(Real)) : INVALID_FIELD;
+    pcgSearchField = pcg ? arena.addField("pcgSearch", sizeof(Real)) : INVALID_FIELD;
+    pcgPreconField = pcg ? arena.addField("pcgPrecon", sizeof(Real)) : INVALID_FIELD;
 
     // ink diffusion fields
+    FieldHandle newRedInkField = INVALID_FIELD, newGreenInkField = INVALID_FIELD, newBlueInkField = INVALID_FIELD;
+    redInkField = greenInkField = blueInkField = INVALID_FIELD;
     if (imageLoaded) {
-        r_ink.resize(totalCells);
-        g_ink.resize(totalCells);
-        b_ink.resize(totalCells);
-        new_r_ink.resize(totalCells);
-        new_g_ink.resize(totalCells);
-        new_b_ink.resize(totalCells);
-        std::fill(r_ink.begin(), r_ink.end(), 0.0f);
-        std::fill(g_ink.begin(), g_ink.end(), 0.0f);
-        std::fill(b_ink.begin(), b_ink.end(), 0.0f);
-        std::fill(new_r_ink.begin(), new_r_ink.end(), 0.0f);
-        std::fill(new_g_ink.begin(), new_g_ink.end(), 0.0f);
-        std::fill(new_b_ink.begin(), new_b_ink.end(), 0.0f);
+        redInkField = arena.addScalarField("r_ink", scalarPrecision);
+        greenInkField = arena.addScalarField("g_ink", scalarPrecision);
+        blueInkField = arena.addScalarField("b_ink", scalarPrecision);
+        newRedInkField = arena.addScalarField("new_r_ink", scalarPrecision);
+        newGreenInkField = arena.addScalarField("new_g_ink", scalarPrecision);
+        newBlueInkField = arena.addScalarField("new_b_ink", scalarPrecision);
+    }
+
+    // zeroed
+    arena.allocate(layout.size, hugePages);
+    floatMirrors.assign(arena.getFieldCount(), std::vector<float>());
+    bindFields();
+
+    // ghost cells stay solid
+    for (int j = 0; j < gridY; j++) {
+        std::fill(s + idx(0, j), s + idx(gridX, j), 1.0f);
+    }
+    d.fill(0, layout.size, 1.0f);
+
+    if (projectionSolver == ProjectionSolver::MULTIGRID) {
+        multigrid.init(layout, traversal, multigridCycle, smoothingIterations);
+    }
 
+    if (imageLoaded) {
         initializeFromImageData(config, imageData);
     }
 
+    // passive scalars
+    passiveScalars.clear();
+    registerPassiveScalar(dField, newDField, false);
+    if (inkInitialized) {
+        registerPassiveScalar(redInkField, newRedInkField, true);
+        registerPassiveScalar(greenInkField, newGreenInkField, true);
+        registerPassiveScalar(blueInkField, newBlueInkField, true);
+    }
+
+    // advection kernel: widest the CPU supports, capped by config, without the ink
+    // masking unless ink is loaded
+    advectRowKernel = selectAdvectRowKernel<Real>(config.simulation.simd, scalarPrecision, inkInitialized, simdLevel);
+
+    // step variant for the features this run uses
+    unsigned features = 0;
+    if (gravity != 0.0f) features |= STEP_GRAVITY;
+    if (curlNeeded) features |= STEP_CURL;
+    if (doVorticity) features |= STEP_VORTICITY;
+    if (activityEnabled) features |= STEP_ACTIVITY;
+    static const StepFunction steps[] = {
+        &BasicFluidSimulator::step<0>, &BasicFluidSimulator::step<1>,
+        &BasicFluidSimulator::step<2>, &BasicFluidSimulator::step<3>,
+        &BasicFluidSimulator::step<4>, &BasicFluidSimulator::step<5>,
+        &BasicFluidSimulator::step<6>, &BasicFluidSimulator::step<7>,
+        &BasicFluidSimulator::step<8>, &BasicFluidSimulator::step<9>,
+        &BasicFluidSimulator::step<10>, &BasicFluidSimulator::step<11>,
+        &BasicFluidSimulator::step<12>, &BasicFluidSimulator::step<13>,
+        &BasicFluidSimulator::step<14>, &BasicFluidSimulator::step<15>,
+    };
+    stepFunction = steps[features];
+
+    // every tile starts active, so the first step runs everywhere
+    activity.resize(gridX, gridY, activityTileSize);
+    tileStats.resize(activity.tileCount());
+
     // initialize circle
     circleX = gridX / 2;
     circleY = gridY / 2;
@@ -139,80 +239,154 @@ void FluidSimulator::init(const Config& config, const ImageData* imageData) {
     }
 
     // setup obstacles
+    buildBoundaries(config);
     setupCircle();
-    setupEdges();
+    setupEdges({0, gridX, 0, gridY});
+    obstaclesDirty = {0, gridX, 0, gridY};
+    rebuildCellFlags();
 }
 
 
-void FluidSimulator::setupCircle() {
-    for (int i = circleX - circleRadius; i < circleX + circleRadius; i++) {
-        for (int j = circleY - circleRadius; j < circleY + circleRadius; j++) {
-            if (i >= 0 && i < gridX && j >= 0 && j < gridY) {
-                float dx = (i + 0.5f) - circleX;
-                float dy = (j + 0.5f) - circleY;
-                if (sqrt(dx * dx + dy * dy) <= circleRadius) {
-                    s[idx(i, j)] = 0.0f;
-                }
+template <typename Real>
+void BasicFluidSimulator<Real>::setupCircle() {
+    CellRange box = {std::max(0, circleX - circleRadius), std::min(gridX, circleX + circleRadius),
+                     std::max(0, circleY - circleRadius), std::min(gridY, circleY + circleRadius)};
+    traversal.forEachRowSerial(box, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            Real dx = (i + 0.5f) - circleX;
+            Real dy = (j + 0.5f) - circleY;
+            if (sqrt(dx * dx + dy * dy) <= circleRadius) {
+                s[idx(i, j)] = 0.0f;
             }
         }
-    }
+    });
 }
 
-void FluidSimulator::setupEdges() {
-    int cx = gridX / 2;
-    int cy = gridY / 2;
+template <typename Real>
+void BasicFluidSimulator<Real>::setupEdges(const CellRange& range) {
+    // edge boundaries: solid, except where an outflow opens them
+    auto inRange = [&](int k) {
+        int i = layout.column(k);
+        int j = layout.row(k);
+        return i >= range.iBegin && i < range.iEnd && j >= range.jBegin && j < range.jEnd;
+    };
+    for (int k : edgeCells) {
+        if (inRange(k)) s[k] = 0.0f;
+    }
+    for (const Boundary& boundary : boundaries) {
+        if (!boundary.outflow) continue;
+        for (int k : boundary.cells) {
+            if (inRange(k)) s[k] = 1.0f;
+        }
+    }
+
+    imposeBoundaries(true);
+}
 
+template <typename Real>
+void BasicFluidSimulator<Real>::buildBoundaries(const Config& config) {
+    edgeCells.clear();
     for (int i = 0; i < gridX; i++) {
-        for (int j = 0; j < gridY; j++) {
-            // edge boundaries
-            if (j == 0 || j == gridY-1 || i == 0 || i == gridX - 1) {
-                s[idx(i, j)] = 0.0f;
-            }
+        edgeCells.push_back(idx(i, 0));
+        edgeCells.push_back(idx(i, gridY - 1));
+    }
+    for (int j = 1; j < gridY - 1; j++) {
+        edgeCells.push_back(idx(0, j));
+        edgeCells.push_back(idx(gridX - 1, j));
+    }
 
-            // configurable wind tunnel
-            // TODO configure direction by angle between 2 points; this is janky
-            if (windTunnelSide != -1) {
-
-                switch (windTunnelSide) {
-                    case 0: // left
-                        if (i == 1 && j >= windTunnelStartCell && j < windTunnelEndCell) {
-                            x[idx(i, j)] = windTunnelVelocity;
-                        }
-                        if (i == 0 && j >= windTunnelStartCell && j < windTunnelEndCell) {
-                            d[idx(i, j)] = 0.0f;
-                        }
-                        break;
-                    case 1: // top
-                        if (j == gridY-1 && i >= windTunnelStartCell && i < windTunnelEndCell) {
-                            y[idx(i, j)] = -windTunnelVelocity;
-                            d[idx(i, j)] = 0.0f;
-                        }
-                        break;
-                    case 2: // bottom
-                        if (j == 1 && i >= windTunnelStartCell && i < windTunnelEndCell) {
-                            y[idx(i, j)] = windTunnelVelocity;
-                        }
-                        if (j == 0 && i >= windTunnelStartCell && i < windTunnelEndCell) {
-                            d[idx(i, j)] = 0.0f;
-                        }
-                        break;
-                    case 3: // right
-                        if (i == gridX-1 && j >= windTunnelStartCell && j < windTunnelEndCell) {
-                            x[idx(i, j)] = -windTunnelVelocity;
-                            d[idx(i, j)] = 0.0f;
-                        }
-                        break;
-                }
+    std::vector<BoundaryConfig> openings;
+    if (windTunnelSide != -1) {
+        BoundaryConfig windTunnel;
+        windTunnel.side = windTunnelSide;
+        windTunnel.startPosition = windTunnelStart;
+        windTunnel.endPosition = windTunnelEnd;
+        windTunnel.velocity = static_cast<float>(windTunnelVelocity);
+        openings.push_back(windTunnel);
+    }
+    openings.insert(openings.end(), config.simulation.boundaries.begin(), config.simulation.boundaries.end());
+
+    // TODO configure direction by angle between 2 points; this is janky
+    boundaries.clear();
+    for (const BoundaryConfig& opening : openings) {
+        if (opening.side < 0 || opening.side > 3) continue;
+        Boundary boundary;
+        boundary.outflow = opening.type == BoundaryType::OUTFLOW;
+        boundary.alongX = opening.side == 0 || opening.side == 3;
+        boundary.velocity = (opening.side == 0 || opening.side == 2) ? opening.velocity : -opening.velocity;
+
+        // outflows leave the corners solid, so their cells only neighbor the interior
+        int extent = boundary.alongX ? gridY : gridX;
+        int lo = boundary.outflow ? 1 : 0;
+        int first = std::max(lo, std::min(extent - 1, static_cast<int>(opening.startPosition * extent)));
+        int last = std::max(lo, std::min(extent - 1, static_cast<int>(opening.endPosition * extent)));
+        for (int n = first; n < last; n++) {
+            switch (opening.side) {
+                case 0: // left
+                    boundary.faces.push_back(idx(1, n));
+                    boundary.cells.push_back(idx(0, n));
+                    break;
+                case 1: // top
+                    boundary.faces.push_back(idx(n, gridY - 1));
+                    boundary.cells.push_back(idx(n, gridY - 1));
+                    break;
+                case 2: // bottom
+                    boundary.faces.push_back(idx(n, 1));
+                    boundary.cells.push_back(idx(n, 0));
+                    break;
+                case 3: // right
+                    boundary.faces.push_back(idx(gridX - 1, n));
+                    boundary.cells.push_back(idx(gridX - 1, n));
+                    break;
             }
         }
+        switch (opening.side) {
+            case 0: boundary.inward = 1; break;
+            case 1: boundary.inward = -layout.stride; break;
+            case 2: boundary.inward = layout.stride; break;
+            default: boundary.inward = -1; break;
+        }
+        boundaries.push_back(std::move(boundary));
+    }
+
+    hasOutflow = false;
+    for (const Boundary& boundary : boundaries) {
+        hasOutflow = hasOutflow || (boundary.outflow && !boundary.cells.empty());
     }
 
     pipeHeight = windTunnelEndCell - windTunnelStartCell;
 }
 
-void FluidSimulator::initializeFromImageData(const Config& config, const ImageData* imageData) {
+template <typename Real>
+void BasicFluidSimulator<Real>::imposeBoundaries(bool clearSmoke) {
+    for (const Boundary& boundary : boundaries) {
+        Real* faces = boundary.alongX ? x : y;
+        if (boundary.outflow) {
+            // zero gradient guess for the projection, which then sets the faces from the
+            // zero pressure outside
+            for (int k : boundary.faces) {
+                faces[k] = faces[k + boundary.inward];
+            }
+            continue;
+        }
+        for (int k : boundary.faces) {
+            faces[k] = boundary.velocity;
+        }
+        if (clearSmoke) {
+            for (int k : boundary.cells) {
+                d.set(k, 0.0f);
+            }
+        }
+    }
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::initializeFromImageData(const Config& config, const ImageData* imageData) {
     if (!imageData || !imageData->pixels) return;
-    Uint8* pixels = static_cast<Uint8*>(imageData->pixels);
+    uint8_t* pixels = static_cast<uint8_t*>(imageData->pixels);
+    ScalarField r_ink = scalarField(redInkField);
+    ScalarField g_ink = scalarField(greenInkField);
+    ScalarField b_ink = scalarField(blueInkField);
 
     float DARKEST_BLACK = 0.05f; // minimum ink color; if it's 0 ink persists because it fucks up some multiplication somewhere
     for (int j = 0; j < gridY; j++) {
@@ -223,7 +397,7 @@ void FluidSimulator::initializeFromImageData(const Config& config, const ImageDa
 
             if (imgX >= 0 && imgX < imageData->width && imgY >= 0 && imgY < imageData->height) {
                 int pixelIndex = imgY * imageData->width + imgX;
-                Uint8 r, g, b;
+                uint8_t r, g, b;
                 if (imageData->bytesPerPixel == 4) {
                     r = pixels[pixelIndex * imageData->bytesPerPixel + imageData->rShift / 8];
                     g = pixels[pixelIndex * imageData->bytesPerPixel + imageData->gShift / 8];
@@ -235,13 +409,9 @@ void FluidSimulator::initializeFromImageData(const Config& config, const ImageDa
                 }
 
                 // normalize
-                r_ink[cellIndex] = std::max(0.05f, std::min(1.0f, r / 255.0f));
-                g_ink[cellIndex] = std::max(0.05f, std::min(1.0f, g / 255.0f));
-                b_ink[cellIndex] = std::max(0.05f, std::min(1.0f, b / 255.0f));
-
-                new_r_ink[cellIndex] = r_ink[cellIndex];
-                new_g_ink[cellIndex] = g_ink[cellIndex];
-                new_b_ink[cellIndex] = b_ink[cellIndex];
+                r_ink.set(cellIndex, std::max(0.05f, std::min(1.0f, r / 255.0f)));
+                g_ink.set(cellIndex, std::max(0.05f, std::min(1.0f, g / 255.0f)));
+                b_ink.set(cellIndex, std::max(0.05f, std::min(1.0f, b / 255.0f)));
             }
         }
     }
@@ -249,60 +419,391 @@ void FluidSimulator::initializeFromImageData(const Config& config, const ImageDa
     inkInitialized = true;
 }
 
-void FluidSimulator::update() {
-    integrate();
-    project();
-    extrapolate();
-    advect();
-    if (doVorticity) {
-        applyVorticity();
+template <typename Real>
+void BasicFluidSimulator<Real>::update() {
+    PROFILE_STAGE(profiler, STAGE_STEP);
+    if (circleMovePending) {
+        moveCircle(targetCircleX, targetCircleY);
+        circleMovePending = false;
     }
+    if (!isEmpty(obstaclesDirty)) {
+        rebuildCellFlags();
+    }
+    (this->*stepFunction)();
 }
 
-void FluidSimulator::integrate() {
-    if (gravity == 0.0f) return;
+template <typename Real>
+template <unsigned Features>
+void BasicFluidSimulator<Real>::step() {
+    {
+        PROFILE_STAGE(profiler, STAGE_INTEGRATE);
+        if constexpr ((Features & STEP_GRAVITY) != 0) {
+            integrate();
+        }
+        // openings, O(perimeter); outflows follow the interior every step
+        imposeBoundaries(true);
+    }
+    {
+        PROFILE_STAGE(profiler, STAGE_PROJECT);
+        project();
+    }
+    {
+        PROFILE_STAGE(profiler, STAGE_EXTRAPOLATE);
+        extrapolate();
+    }
+    if constexpr ((Features & STEP_ACTIVITY) != 0) {
+        PROFILE_STAGE(profiler, STAGE_ACTIVITY);
+        classifyActivity();
+    }
+    {
+        PROFILE_STAGE(profiler, STAGE_ADVECT);
+        advect();
+    }
+    if constexpr ((Features & STEP_CURL) != 0) {
+        PROFILE_STAGE(profiler, STAGE_VORTICITY);
+        computeCurl();
+        if constexpr ((Features & STEP_VORTICITY) != 0) {
+            applyVorticity();
+        }
+    }
+}
 
-    for (int i = 1; i < gridX; i++) {
-        for (int j = 1; j < gridY; j++) {
-            if (s[idx(i, j)] != 0.0f && s[idx(i, j-1)] != 0.0f) {
+template <typename Real>
+void BasicFluidSimulator<Real>::integrate() {
+    traversal.forEachRow({1, gridX, 1, gridY}, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            if (cellFlags[idx(i, j)] & CELL_YM) {
                 y[idx(i, j)] += gravity * timeStep;
             }
         }
+    });
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::project() {
+    if (warmStart) {
+        // start from the previous step's pressure instead of zero
+        warmStartCorrection();
+    } else {
+        std::fill(p, p + layout.size, 0.0f);
+    }
+
+    // the mean divergence can't be projected out of the closed box, so tolerance-based
+    // solvers relax towards it instead of zero (otherwise the system has no solution);
+    // an outflow's zero pressure cells take it out of the box instead
+    divergenceOffset = !hasOutflow && (earlyExit || projectionSolver == ProjectionSolver::PCG ||
+                                       projectionSolver == ProjectionSolver::MULTIGRID) ? meanDivergence() : 0.0f;
+
+    switch (projectionSolver) {
+        case ProjectionSolver::RED_BLACK:
+            projectRedBlack();
+            break;
+        case ProjectionSolver::PCG:
+            projectPCG();
+            break;
+        case ProjectionSolver::MULTIGRID:
+            projectMultigrid();
+            break;
+        case ProjectionSolver::GAUSS_SEIDEL:
+        default:
+            projectGaussSeidel();
+            break;
+    }
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::projectGaussSeidel() {
+    if (warmStart) applyPressureCorrection(solverCorrection);
+
+    // with early exit, sweep until the residual tracked during a sweep is small enough
+    int sweeps = earlyExit ? projectionMaxIterations : gsIterations;
+    projectionIterations = 0;
+    projectionResidual = 0.0f;
+
+    if (blockDepth > 1) {
+        sweepWavefront(sweeps, false);
+        return;
+    }
+
+    // lexicographic Gauss-Seidel projection (serial, row-major; each cell sees its
+    // neighbors' updates)
+    for (int n = 0; n < sweeps; n++) {
+        Real sweepResidual = 0.0f;
+        traversal.forEachRowSerial({1, gridX - 1, 1, gridY - 1}, [&](int j, int iBegin, int iEnd) {
+            Real rowResidual = 0.0f;
+            for (int i = iBegin; i < iEnd; i++) {
+                rowResidual = std::max(rowResidual, relaxCell(i, j));
+            }
+            sweepResidual = std::max(sweepResidual, rowResidual);
+        });
+
+        projectionIterations = n + 1;
+        projectionResidual = sweepResidual;
+        if (earlyExit && sweepResidual <= projectionTolerance) break;
+    }
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::projectRedBlack() {
+    if (warmStart) applyPressureCorrection(solverCorrection);
+
+    int sweeps = earlyExit ? projectionMaxIterations : gsIterations;
+    projectionIterations = 0;
+    projectionResidual = 0.0f;
+
+    if (blockDepth > 1) {
+        sweepWavefront(sweeps, true);
+        return;
+    }
+
+    // checkerboard ordering: a cell only touches its own four faces, and no two
+    // cells of the same color share a face, so each color can be swept in parallel
+    // with a result that doesn't depend on the thread count
+    const CellRange interior = {1, gridX - 1, 1, gridY - 1};
+    Real sweepResidual = 0.0f;
+    #pragma omp parallel
+    for (int n = 0; n < sweeps; n++) {
+        #pragma omp single
+        sweepResidual = 0.0f;
+
+        for (int color = 0; color < 2; color++) {
+            traversal.maxOverRowsInParallel(interior, sweepResidual, [&](int j, int iBegin, int iEnd) {
+                Real residual = 0.0f;
+                for (int i = firstOfColor(iBegin, j, color); i < iEnd; i += 2) {
+                    residual = std::max(residual, relaxCell(i, j));
+                }
+                return residual;
+            });
+        }
+
+        // every thread sees the same reduced residual, so they all leave on the same sweep
+        bool done = earlyExit && sweepResidual <= projectionTolerance;
+        #pragma omp single
+        {
+            projectionIterations = n + 1;
+            projectionResidual = sweepResidual;
+        }
+        if (done) break;
+    }
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::sweepWavefront(int sweeps, bool redBlack) {
+    // temporal blocking: blockDepth sweeps run as one wavefront over blocks of rows and
+    // column chunks, so each block is relaxed blockDepth times per trip through memory
+    // instead of once. a cell only touches faces shared with its four neighbors, so the
+    // fields match the unblocked sweeps exactly; red-black sweeps are one pass per color
+    // and, unlike lexicographic ones, don't order the chunks of a row. early exit is
+    // checked once per block, against the block's last sweep
+    const CellRange interior = {1, gridX - 1, 1, gridY - 1};
+    const int passesPerSweep = redBlack ? 2 : 1;
+    std::vector<Real> passResiduals(blockDepth * passesPerSweep);
+
+    for (int n = 0; n < sweeps;) {
+        int depth = std::min(blockDepth, sweeps - n);
+        traversal.maxOverRowWavefront(interior, depth * passesPerSweep, !redBlack, passResiduals.data(),
+            [&](int pass, int j, int iBegin, int iEnd) {
+                Real residual = 0.0f;
+                int first = redBlack ? firstOfColor(iBegin, j, pass & 1) : iBegin;
+                int step = redBlack ? 2 : 1;
+                for (int i = first; i < iEnd; i += step) {
+                    residual = std::max(residual, relaxCell(i, j));
+                }
+                return residual;
+            });
+        n += depth;
+
+        Real sweepResidual = 0.0f;
+        for (int pass = (depth - 1) * passesPerSweep; pass < depth * passesPerSweep; pass++) {
+            sweepResidual = std::max(sweepResidual, passResiduals[pass]);
+        }
+        projectionIterations = n;
+        projectionResidual = sweepResidual;
+        if (earlyExit && sweepResidual <= projectionTolerance) break;
+    }
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::projectPCG() {
+    // solves A q = -div for a per-cell correction q, where A is the 5-point
+    // Laplacian restricted to fluid cells; q plays the role of the SOR updates
+    // summed over all iterations, so p = q * pressureMultiplier
+    Real* q = solverCorrection;
+    Real* r = solverResidual;
+    Real* z = pcgAux;
+    Real* search = pcgSearch;
+
+    if (!warmStart) std::fill(q, q + layout.size, 0.0f);
+    buildPressureRHS(r);
+
+    // a warm start begins from the residual of the previous solution
+    if (warmStart) {
+        applyLaplacian(q, z);
+        #pragma omp parallel for
+        for (int k = 0; k < layout.size; k++) {
+            r[k] -= z[k];
+        }
+    }
+
+    buildPreconditioner();
+
+    projectionIterations = 0;
+    projectionResidual = maxAbs(r);
+    if (projectionResidual > projectionTolerance) {
+        applyPreconditioner(r, z);
+        std::copy(z, z + layout.size, search);
+        double sigma = dot(z, r);
+
+        for (int n = 0; n < projectionMaxIterations; n++) {
+            applyLaplacian(search, z);
+            double denom = dot(search, z);
+            if (denom == 0.0) break;
+            Real alpha = static_cast<Real>(sigma / denom);
+
+            #pragma omp parallel for
+            for (int k = 0; k < layout.size; k++) {
+                q[k] += alpha * search[k];
+                r[k] -= alpha * z[k];
+            }
+
+            projectionIterations = n + 1;
+            projectionResidual = maxAbs(r);
+            if (projectionResidual <= projectionTolerance) break;
+
+            applyPreconditioner(r, z);
+            double sigmaNew = dot(z, r);
+            Real beta = static_cast<Real>(sigmaNew / sigma);
+            sigma = sigmaNew;
+
+            #pragma omp parallel for
+            for (int k = 0; k < layout.size; k++) {
+                search[k] = z[k] + beta * search[k];
+            }
+        }
     }
+
+    applyPressureCorrection(q);
 }
 
-void FluidSimulator::project() {
-    // reset pressure field
-    std::fill(p.begin(), p.end(), 0.0f);
+template <typename Real>
+void BasicFluidSimulator<Real>::projectMultigrid() {
+    // same system as PCG; the residual history keeps the max residual after each cycle
+    Real* q = solverCorrection;
+    Real* rhs = solverResidual;
 
-    // Gauss-Seidel projection
-    for (int n = 0; n < gsIterations; n++) {
-        for (int i = 1; i < gridX - 1; i++) {
-            for (int j = 1; j < gridY - 1; j++) {
-                if (s[idx(i, j)] == 0.0f) continue;
+    if (!warmStart) std::fill(q, q + layout.size, 0.0f);
+    buildPressureRHS(rhs);
 
-                float sx0 = s[idx(i+1, j)];
-                float sx1 = s[idx(i-1, j)];
-                float sy0 = s[idx(i, j+1)];
-                float sy1 = s[idx(i, j-1)];
-                float b = sx0 + sx1 + sy0 + sy1;
+    projectionIterations = multigrid.solve(rhs, q, projectionTolerance, projectionMaxIterations);
+    projectionResidual = multigrid.getResidualHistory().back();
 
-                if (b == 0.0f) continue;
+    applyPressureCorrection(q);
+}
 
-                float adjustedDivergence = -overrelaxationCoefficient * div(i, j) / b;
+template <typename Real>
+void BasicFluidSimulator<Real>::buildPressureRHS(Real* rhs) {
+    // right hand side -div; the closed box is a pure Neumann problem, so remove the
+    // mean divergence (e.g. from the wind tunnel inflow) to keep the system consistent
+    traversal.forEachRow({0, gridX, 0, gridY}, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            bool fluid = i > 0 && i < gridX - 1 && j > 0 && j < gridY - 1 && valence(i, j) != 0.0f;
+            rhs[idx(i, j)] = fluid ? divergenceOffset - div(i, j) : 0.0f;
+        }
+    });
+}
 
-                x[idx(i+1, j)] += adjustedDivergence * sx0;
-                x[idx(i, j)] -= adjustedDivergence * sx1;
-                y[idx(i, j+1)] += adjustedDivergence * sy0;
-                y[idx(i, j)] -= adjustedDivergence * sy1;
-                p[idx(i, j)] += adjustedDivergence * pressureMultiplier;
+template <typename Real>
+Real BasicFluidSimulator<Real>::meanDivergence() {
+    struct DivergenceSum {
+        double sum = 0.0;
+        int cells = 0;
+        DivergenceSum& operator+=(const DivergenceSum& other) {
+            sum += other.sum;
+            cells += other.cells;
+            return *this;
+        }
+    };
+
+    // summed per row, then in row order, so the offset doesn't depend on the thread count
+    DivergenceSum total = traversal.sumOverRows<DivergenceSum>({1, gridX - 1, 1, gridY - 1},
+        [&](int j, int iBegin, int iEnd) {
+            DivergenceSum row;
+            for (int i = iBegin; i < iEnd; i++) {
+                if (valence(i, j) != 0.0f) {
+                    row.sum += div(i, j);
+                    row.cells++;
+                }
             }
+            return row;
+        });
+    return total.cells > 0 ? static_cast<Real>(total.sum / total.cells) : 0.0f;
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::warmStartCorrection() {
+    // recover the per-cell correction from the previous pressure; cells that
+    // became solid since the last step start from zero
+    traversal.forEachRow({0, gridX, 0, gridY}, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            bool fluid = i > 0 && i < gridX - 1 && j > 0 && j < gridY - 1 && valence(i, j) != 0.0f;
+            solverCorrection[idx(i, j)] = fluid ? p[idx(i, j)] / pressureMultiplier : 0.0f;
+        }
+    });
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::applyPressureCorrection(const Real* q) {
+    // apply the correction to every face between two fluid cells
+    traversal.forEachRow({1, gridX - 1, 1, gridY - 1}, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            uint8_t f = cellFlags[idx(i, j)];
+            x[idx(i, j)] += cellCoeff(f, CELL_XM) * (q[idx(i-1, j)] - q[idx(i, j)]);
+            y[idx(i, j)] += cellCoeff(f, CELL_YM) * (q[idx(i, j-1)] - q[idx(i, j)]);
+            p[idx(i, j)] = q[idx(i, j)] * pressureMultiplier;
+        }
+        // the far face of the row belongs to whichever span ends the row
+        if (iEnd == gridX - 1) {
+            x[idx(gridX-1, j)] += cellCoeff(cellFlags[idx(gridX-2, j)], CELL_XP) * q[idx(gridX-2, j)];
         }
+    });
+    for (int i = 1; i < gridX - 1; i++) {
+        y[idx(i, gridY-1)] += cellCoeff(cellFlags[idx(i, gridY-2)], CELL_YP) * q[idx(i, gridY-2)];
     }
 }
 
-void FluidSimulator::extrapolate() {
-    // set boundary tiles to copy neighbors
+template <typename Real>
+Real BasicFluidSimulator<Real>::relaxCell(int i, int j) {
+    // returns the cell's residual before the update (0 for skipped cells)
+    const int k = idx(i, j);
+    const int stride = layout.stride;
+    uint8_t f = cellFlags[k];
+    if (!(f & CELL_FLUID)) return 0.0f;
+
+    Real sx0 = cellCoeff(f, CELL_XP);
+    Real sx1 = cellCoeff(f, CELL_XM);
+    Real sy0 = cellCoeff(f, CELL_YP);
+    Real sy1 = cellCoeff(f, CELL_YM);
+    Real b = sx0 + sx1 + sy0 + sy1;
+
+    if (b == 0.0f) return 0.0f;
+
+    Real divergence = x[k+1] - x[k] + y[k+stride] - y[k] - divergenceOffset;
+    Real adjustedDivergence = -overrelaxationCoefficient * divergence / b;
+
+    x[k+1] += adjustedDivergence * sx0;
+    x[k] -= adjustedDivergence * sx1;
+    y[k+stride] += adjustedDivergence * sy0;
+    y[k] -= adjustedDivergence * sy1;
+    p[k] += adjustedDivergence * pressureMultiplier;
+
+    return std::fabs(divergence);
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::extrapolate() {
+    // set boundary tiles to copy neighbors. like the ghost fill below, these are
+    // O(perimeter) copies along the frame and past it, so they loop directly instead of
+    // through the traversal, whose spans are rows of the grid
     for (int i = 0; i < gridX; i++) {
         x[idx(i, 0)] = x[idx(i, 1)];
         x[idx(i, gridY-1)] = x[idx(i, gridY-2)];
@@ -311,193 +812,429 @@ void FluidSimulator::extrapolate() {
         y[idx(0, j)] = y[idx(1, j)];
         y[idx(gridX-1, j)] = y[idx(gridX-2, j)];
     }
+
+    // advection reads one cell past the far edges (and bilinear sampling one more),
+    // so the ghost layers hold clamped copies of the edge values
+    fillGhostCells(x);
+    fillGhostCells(y);
+    for (const PassiveScalar& scalar : passiveScalars) {
+        switch (scalarPrecision) {
+            case ScalarPrecision::FP32: fillGhostCells(arena.get<float>(scalar.field)); break;
+            default: fillGhostCells(arena.get<uint16_t>(scalar.field)); break; // plain copies, any 16 bit format
+        }
+    }
 }
 
-void FluidSimulator::advect() {
-    newX = x;
-    newY = y;
-    newD = d;
-    if (inkInitialized) {
-        new_r_ink = r_ink;
-        new_g_ink = g_ink;
-        new_b_ink = b_ink;
-    }
-
-    #pragma omp parallel for
-    for (int i = 1; i < gridX; i++) {
-        for (int j = 1; j < gridY; j++) {
-            if (s[idx(i, j)] != 0.0f) {
-                // x vel advection
-                if (s[idx(i-1, j)] != 0.0f && j < gridY-1) {
-                    float x0 = i * cellHeight;
-                    float y0 = j * cellHeight + halfCellHeight;
-                    x0 -= x[idx(i, j)] * timeStep;
-                    y0 -= neighborhoodY(i, j) * timeStep;
-                    newX[idx(i, j)] = sample(x0, y0, 0);
-                }
+template <typename Real>
+template <typename T>
+void BasicFluidSimulator<Real>::fillGhostCells(T* field) {
+    for (int j = 0; j < gridY; j++) {
+        for (int g = 1; g <= GHOST_LAYERS; g++) {
+            field[idx(-g, j)] = field[idx(0, j)];
+            field[idx(gridX-1+g, j)] = field[idx(gridX-1, j)];
+        }
+    }
+    // rows copied whole, so the corners get clamped too
+    for (int g = 1; g <= GHOST_LAYERS; g++) {
+        std::copy(field + idx(-GHOST_LAYERS, 0), field + idx(gridX+GHOST_LAYERS, 0),
+                  field + idx(-GHOST_LAYERS, -g));
+        std::copy(field + idx(-GHOST_LAYERS, gridY-1), field + idx(gridX+GHOST_LAYERS, gridY-1),
+                  field + idx(-GHOST_LAYERS, gridY-1+g));
+    }
+}
 
-                // y vel advection
-                if (s[idx(i, j-1)] != 0.0f && i < gridX-1) {
-                    float x0 = i * cellHeight + halfCellHeight;
-                    float y0 = j * cellHeight;
-                    x0 -= neighborhoodX(i, j) * timeStep;
-                    y0 -= y[idx(i, j)] * timeStep;
-                    newY[idx(i, j)] = sample(x0, y0, 1);
+// min and max of a passive scalar over a row span, in its storage type T
+template <typename T>
+static void scalarBounds(const void* field, int k, int count, float& lo, float& hi) {
+    const T* values = static_cast<const T*>(field) + k;
+    for (int n = 0; n < count; n++) {
+        float value = toFloat(values[n]);
+        lo = std::min(lo, value);
+        hi = std::max(hi, value);
+    }
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::classifyActivity() {
+    const int tiles = activity.tileCount();
+    const int fieldCount = 2 + static_cast<int>(passiveScalars.size());
+
+    // per tile: largest velocity component and bounds of every advected field
+    Real maxSpeed = 0.0f;
+    #pragma omp parallel for schedule(static) reduction(max:maxSpeed)
+    for (int tile = 0; tile < tiles; tile++) {
+        CellRange cells = activity.tileCells(tile);
+        cells.iEnd = std::min(cells.iEnd, gridX);
+        cells.jEnd = std::min(cells.jEnd, gridY);
+        TileStats& stats = tileStats[tile];
+        stats.speed = 0.0f;
+        std::fill(stats.lo, stats.lo + fieldCount, std::numeric_limits<Real>::max());
+        std::fill(stats.hi, stats.hi + fieldCount, std::numeric_limits<Real>::lowest());
+
+        // tiles are already spread over the threads; each walks its own rows
+        traversal.forEachRowSerial(cells, [&](int j, int iBegin, int iEnd) {
+            int k = idx(iBegin, j);
+            int count = iEnd - iBegin;
+            for (int i = 0; i < count; i++) {
+                stats.speed = std::max(stats.speed, std::max(std::fabs(x[k + i]), std::fabs(y[k + i])));
+                stats.lo[0] = std::min(stats.lo[0], x[k + i]);
+                stats.hi[0] = std::max(stats.hi[0], x[k + i]);
+                stats.lo[1] = std::min(stats.lo[1], y[k + i]);
+                stats.hi[1] = std::max(stats.hi[1], y[k + i]);
+            }
+            for (int n = 2; n < fieldCount; n++) {
+                const void* field = arena.get<void>(passiveScalars[n - 2].field);
+                float lo = static_cast<float>(stats.lo[n]);
+                float hi = static_cast<float>(stats.hi[n]);
+                switch (scalarPrecision) {
+                    case ScalarPrecision::FP16: scalarBounds<Half>(field, k, count, lo, hi); break;
+                    case ScalarPrecision::BF16: scalarBounds<BFloat16>(field, k, count, lo, hi); break;
+                    default: scalarBounds<float>(field, k, count, lo, hi); break;
                 }
+                stats.lo[n] = lo;
+                stats.hi[n] = hi;
+            }
+        });
+        maxSpeed = std::max(maxSpeed, stats.speed);
+    }
 
-                // smoke advection
-                float x0 = (x[idx(i, j)] + x[idx(i+1, j)]) / 2.0f;
-                float y0 = (y[idx(i, j)] + y[idx(i, j+1)]) / 2.0f;
-                float x1 = i * cellHeight + halfCellHeight - x0 * timeStep;
-                float y1 = j * cellHeight + halfCellHeight - y0 * timeStep;
-                newD[idx(i, j)] = sample(x1, y1, 2);
-
-                // ink advection
-                if (inkInitialized) {
-                    if (shouldSkipInkCell(i, j)) continue;
-
-                    float vel_x = (x[idx(i, j)] + x[idx(i+1, j)]) / 2.0f;
-                    float vel_y = (y[idx(i, j)] + y[idx(i, j+1)]) / 2.0f;
-        
-                    float x0 = i * cellHeight + halfCellHeight - vel_x * timeStep;
-                    float y0 = j * cellHeight + halfCellHeight - vel_y * timeStep;
-        
-                    new_r_ink[idx(i, j)] = sample(x0, y0, 3);
-                    new_g_ink[idx(i, j)] = sample(x0, y0, 4);
-                    new_b_ink[idx(i, j)] = sample(x0, y0, 5);
+    // a cell's step reads within the backtrace distance plus two cells (interpolation
+    // stencil, face averages, curl), so a tile is judged on its neighbors within that reach
+    Real cfl = maxSpeed * timeStep / cellHeight;
+    int tileSize = activity.getTileSize();
+    int reach = (static_cast<int>(std::ceil(cfl)) + 2 + tileSize - 1) / tileSize;
+    const int tilesX = activity.getTilesX();
+    const int tilesY = activity.getTilesY();
+    const Real confinement = doVorticity ? vorticity * timeStep : 0.0f;
+
+    activity.beginUpdate();
+    #pragma omp parallel for schedule(static)
+    for (int tile = 0; tile < tiles; tile++) {
+        int tileX = tile % tilesX;
+        int tileY = tile / tilesX;
+        Real speed = 0.0f;
+        Real lo[2 + MAX_PASSIVE_SCALARS], hi[2 + MAX_PASSIVE_SCALARS];
+        std::fill(lo, lo + fieldCount, std::numeric_limits<Real>::max());
+        std::fill(hi, hi + fieldCount, std::numeric_limits<Real>::lowest());
+        for (int ty = std::max(0, tileY - reach); ty <= std::min(tilesY - 1, tileY + reach); ty++) {
+            for (int tx = std::max(0, tileX - reach); tx <= std::min(tilesX - 1, tileX + reach); tx++) {
+                const TileStats& stats = tileStats[ty * tilesX + tx];
+                speed = std::max(speed, stats.speed);
+                for (int n = 0; n < fieldCount; n++) {
+                    lo[n] = std::min(lo[n], stats.lo[n]);
+                    hi[n] = std::max(hi[n], stats.hi[n]);
                 }
             }
         }
+
+        // bilinear interpolation moved by at most d cells per axis changes a value by at
+        // most 2d times the field's range; the confinement force is bounded by the curl,
+        // at most twice the velocity range
+        Real velocityRange = std::max(hi[0] - lo[0], hi[1] - lo[1]);
+        Real range = velocityRange;
+        for (int n = 2; n < fieldCount; n++) {
+            range = std::max(range, hi[n] - lo[n]);
+        }
+        Real advectionChange = 2.0f * speed * timeStep / cellHeight * range;
+        Real confinementChange = 2.0f * confinement * velocityRange;
+        activity.setActive(tile, wakeAllTiles || std::max(advectionChange, confinementChange) > activityTolerance);
     }
+    activity.endUpdate();
+    wakeAllTiles = false;
+}
 
-    x = newX;
-    y = newY;
-    d = newD;
-    if (inkInitialized) {
-        r_ink = new_r_ink;
-        g_ink = new_g_ink;
-        b_ink = new_b_ink;
+template <typename Real>
+void BasicFluidSimulator<Real>::advect() {
+    BasicAdvectionFields<Real> fields;
+    fields.gridX = gridX;
+    fields.gridY = gridY;
+    fields.stride = layout.stride;
+    fields.origin = layout.origin;
+    fields.cellHeight = cellHeight;
+    fields.halfCellHeight = halfCellHeight;
+    fields.timeStep = timeStep;
+    fields.sampler = sampler;
+    fields.flags = cellFlags;
+    fields.u = x;
+    fields.v = y;
+    fields.uNext = newX;
+    fields.vNext = newY;
+    fields.scalarPrecision = scalarPrecision;
+    fields.scalarCount = static_cast<int>(passiveScalars.size());
+    for (int n = 0; n < fields.scalarCount; n++) {
+        fields.scalars[n] = arena.get<void>(passiveScalars[n].field);
+        fields.scalarsNext[n] = arena.get<void>(passiveScalars[n].next);
+        fields.scalarIsInk[n] = passiveScalars[n].isInk;
+    }
+    const size_t scalarBytes = scalarPrecisionBytes(scalarPrecision);
+    auto copyScalar = [&](int n, int k) {
+        std::memcpy(static_cast<char*>(fields.scalarsNext[n]) + k * scalarBytes,
+                    static_cast<const char*>(fields.scalars[n]) + k * scalarBytes, scalarBytes);
+    };
+    fields.inkSkipRowBegin = gridY / 2 - pipeHeight / 2;
+    fields.inkSkipRowEnd = gridY / 2 + pipeHeight / 2;
+
+    // the loop below writes every cell it visits (advected or carried over), so the
+    // back buffers only need the untouched first row and column copied before the swap
+    for (int i = 0; i < gridX; i++) {
+        newX[idx(i, 0)] = x[idx(i, 0)];
+        newY[idx(i, 0)] = y[idx(i, 0)];
+        for (int n = 0; n < fields.scalarCount; n++) {
+            copyScalar(n, idx(i, 0));
+        }
+    }
+    for (int j = 0; j < gridY; j++) {
+        newX[idx(0, j)] = x[idx(0, j)];
+        newY[idx(0, j)] = y[idx(0, j)];
+        for (int n = 0; n < fields.scalarCount; n++) {
+            copyScalar(n, idx(0, j));
+        }
+    }
+
+    // rows are contiguous, so each row span is handed to the (possibly vectorized) row kernel
+    const CellRange interior = {1, gridX, 1, gridY};
+    auto advectRow = [&](int j, int iBegin, int iEnd) {
+        advectRowKernel(fields, j, iBegin, iEnd);
+    };
+    if (!activityEnabled) {
+        traversal.forEachRow(interior, advectRow);
+    } else {
+        activity.forEachActiveRow(interior, advectRow);
+        // quiet tiles are carried over into the back buffers
+        activity.forEachInactiveRow(interior, [&](int j, int iBegin, int iEnd) {
+            int k = idx(iBegin, j);
+            int count = iEnd - iBegin;
+            std::copy(x + k, x + k + count, newX + k);
+            std::copy(y + k, y + k + count, newY + k);
+            for (int n = 0; n < fields.scalarCount; n++) {
+                std::memcpy(static_cast<char*>(fields.scalarsNext[n]) + k * scalarBytes,
+                            static_cast<const char*>(fields.scalars[n]) + k * scalarBytes, count * scalarBytes);
+            }
+        });
     }
+
+    // ping-pong: the back buffers become the current fields
+    arena.swap(xField, newXField);
+    arena.swap(yField, newYField);
+    for (const PassiveScalar& scalar : passiveScalars) {
+        arena.swap(scalar.field, scalar.next);
+    }
+    bindFields();
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::computeCurl() {
+    const CellRange interior = {1, gridX - 1, 1, gridY - 1};
+    auto curlRow = [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            w[idx(i, j)] = curl(i, j);
+        }
+    };
+    if (!activityEnabled) {
+        traversal.forEachRow(interior, curlRow);
+        return;
+    }
+
+    // curl is kept at zero in quiet tiles
+    activity.forEachActiveRow(interior, curlRow);
+    activity.forEachDeactivatedRow(interior, [&](int j, int iBegin, int iEnd) {
+        std::fill(w + idx(iBegin, j), w + idx(iEnd, j), 0.0f);
+    });
 }
 
-void FluidSimulator::applyVorticity() {
-    #pragma omp parallel for
-    for (int i = 2; i < gridX - 2; i++) {
-        for (int j = 2; j < gridY - 2; j++) {
-            if (s[idx(i, j)] != 0.0f && s[idx(i-1, j)] != 0.0f &&
-                s[idx(i+1, j)] != 0.0f && s[idx(i, j-1)] != 0.0f &&
-                s[idx(i, j+1)] != 0.0f) {
+template <typename Real>
+void BasicFluidSimulator<Real>::applyVorticity() {
+    // reads only the cached curl, so writing x/y in place is race-free
+    const CellRange interior = {2, gridX - 2, 2, gridY - 2};
+    auto confineRow = [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            // fluid with four fluid neighbors
+            if (cellFlags[idx(i, j)] == (CELL_FLUID | CELL_XP | CELL_XM | CELL_YP | CELL_YM)) {
 
-                float dx = fabs(curl(i, j-1)) - fabs(curl(i, j+1));
-                float dy = fabs(curl(i+1, j)) - fabs(curl(i-1, j));
-                float len = sqrt(dx * dx + dy * dy) + vorticityLen;
-                float c = curl(i, j);
+                Real dx = fabs(w[idx(i, j-1)]) - fabs(w[idx(i, j+1)]);
+                Real dy = fabs(w[idx(i+1, j)]) - fabs(w[idx(i-1, j)]);
+                Real len = sqrt(dx * dx + dy * dy) + vorticityLen;
+                Real c = w[idx(i, j)];
 
                 x[idx(i, j)] += timeStep * c * dx * vorticity / len;
                 y[idx(i, j)] += timeStep * c * dy * vorticity / len;
             }
         }
+    };
+    if (activityEnabled) {
+        activity.forEachActiveRow(interior, confineRow);
+    } else {
+        traversal.forEachRow(interior, confineRow);
     }
 }
 
 // helpers
-float FluidSimulator::div(int i, int j) {
+template <typename Real>
+Real BasicFluidSimulator<Real>::div(int i, int j) {
     return x[idx(i+1, j)] - x[idx(i, j)] + y[idx(i, j+1)] - y[idx(i, j)];
 }
 
-float FluidSimulator::curl(int i, int j) {
+template <typename Real>
+Real BasicFluidSimulator<Real>::curl(int i, int j) {
     return x[idx(i, j+1)] - x[idx(i, j-1)] + y[idx(i-1, j)] - y[idx(i+1, j)];
 }
 
-float FluidSimulator::clamp(float n, float min, float max) {
-    return std::min(max, std::max(min, n));
+template <typename Real>
+Real BasicFluidSimulator<Real>::valence(int i, int j) {
+    // number of fluid neighbors of a fluid cell (0 for solid cells)
+    return cellValence(cellFlags[idx(i, j)]);
 }
 
-float FluidSimulator::neighborhoodX(int i, int j) {
-    return (x[idx(i, j-1)] + x[idx(i, j)] + x[idx(i+1, j-1)] + x[idx(i+1, j)]) / 4.0f;
+template <typename Real>
+void BasicFluidSimulator<Real>::buildPreconditioner() {
+    // incomplete Cholesky (IC(0)) in red-black ordering: red cells only couple to
+    // black cells, so the factorization and both triangular solves are one
+    // parallel pass per color; pcgPrecon stores the inverse factored diagonal
+    const CellRange interior = {1, gridX - 1, 1, gridY - 1};
+    const int stride = layout.stride;
+    const uint8_t* flags = cellFlags;
+    Real* precon = pcgPrecon;
+    traversal.forEachRow(interior, [=](int j, int iBegin, int iEnd) {
+        const int row = idx(0, j);
+        for (int i = firstOfColor(iBegin, j, 0); i < iEnd; i += 2) {
+            Real a = cellValence(flags[row + i]);
+            precon[row + i] = a != 0.0f ? 1.0f / a : 0.0f;
+        }
+    });
+
+    traversal.forEachRow(interior, [=](int j, int iBegin, int iEnd) {
+        const int row = idx(0, j);
+        for (int i = firstOfColor(iBegin, j, 1); i < iEnd; i += 2) {
+            int c = row + i;
+            uint8_t f = flags[c];
+            Real a = cellValence(f);
+            if (a == 0.0f) {
+                precon[c] = 0.0f;
+                continue;
+            }
+            Real e = a - cellCoeff(f, CELL_XP) * precon[c + 1]
+                        - cellCoeff(f, CELL_XM) * precon[c - 1]
+                        - cellCoeff(f, CELL_YP) * precon[c + stride]
+                        - cellCoeff(f, CELL_YM) * precon[c - stride];
+            // fall back to the plain diagonal if the dropped fill made the pivot too small
+            if (e < 0.25f * a) e = a;
+            precon[c] = 1.0f / e;
+        }
+    });
 }
 
-float FluidSimulator::neighborhoodY(int i, int j) {
-    return (y[idx(i-1, j)] + y[idx(i, j)] + y[idx(i-1, j+1)] + y[idx(i, j+1)]) / 4.0f;
+template <typename Real>
+void BasicFluidSimulator<Real>::applyPreconditioner(const Real* r, Real* z) {
+    const CellRange interior = {1, gridX - 1, 1, gridY - 1};
+    const int stride = layout.stride;
+    const uint8_t* flags = cellFlags;
+    const Real* precon = pcgPrecon;
+
+    // forward substitution, red cells
+    traversal.forEachRow({0, gridX, 0, gridY}, [=](int j, int iBegin, int iEnd) {
+        const int row = idx(0, j);
+        for (int i = iBegin; i < iEnd; i++) {
+            bool red = ((i + j) & 1) == 0;
+            z[row + i] = red ? r[row + i] * precon[row + i] : 0.0f;
+        }
+    });
+
+    // forward substitution + diagonal scaling + backward substitution, black cells
+    traversal.forEachRow(interior, [=](int j, int iBegin, int iEnd) {
+        const int row = idx(0, j);
+        for (int i = firstOfColor(iBegin, j, 1); i < iEnd; i += 2) {
+            int c = row + i;
+            if (precon[c] == 0.0f) continue;
+            uint8_t f = flags[c];
+            Real t = r[c] + cellCoeff(f, CELL_XP) * z[c + 1] + cellCoeff(f, CELL_XM) * z[c - 1]
+                    + cellCoeff(f, CELL_YP) * z[c + stride] + cellCoeff(f, CELL_YM) * z[c - stride];
+            z[c] = t * precon[c];
+        }
+    });
+
+    // backward substitution, red cells
+    traversal.forEachRow(interior, [=](int j, int iBegin, int iEnd) {
+        const int row = idx(0, j);
+        for (int i = firstOfColor(iBegin, j, 0); i < iEnd; i += 2) {
+            int c = row + i;
+            if (precon[c] == 0.0f) continue;
+            uint8_t f = flags[c];
+            Real t = cellCoeff(f, CELL_XP) * z[c + 1] + cellCoeff(f, CELL_XM) * z[c - 1]
+                    + cellCoeff(f, CELL_YP) * z[c + stride] + cellCoeff(f, CELL_YM) * z[c - stride];
+            z[c] += t * precon[c];
+        }
+    });
 }
 
-float FluidSimulator::sample(float i, float j, int type) {
-    i = clamp(i, cellHeight, xHeight);
-    j = clamp(j, cellHeight, yHeight);
+template <typename Real>
+void BasicFluidSimulator<Real>::applyLaplacian(const Real* v, Real* out) {
+    const int stride = layout.stride;
+    const uint8_t* flags = cellFlags;
+    traversal.forEachRow({1, gridX - 1, 1, gridY - 1}, [=](int j, int iBegin, int iEnd) {
+        const int row = idx(0, j);
+        for (int i = iBegin; i < iEnd; i++) {
+            int c = row + i;
+            uint8_t f = flags[c];
+            if (!(f & CELL_FLUID)) {
+                out[c] = 0.0f;
+                continue;
+            }
+            out[c] = cellValence(f) * v[c]
+                   - cellCoeff(f, CELL_XP) * v[c + 1] - cellCoeff(f, CELL_XM) * v[c - 1]
+                   - cellCoeff(f, CELL_YP) * v[c + stride] - cellCoeff(f, CELL_YM) * v[c - stride];
+        }
+    });
+}
 
-    float xOffset = 0.0f;
-    float yOffset = 0.0f;
+template <typename Real>
+double BasicFluidSimulator<Real>::dot(const Real* a, const Real* b) {
+    // per-row partial sums are added up serially so the result doesn't depend on thread count
+    return traversal.sumOverRows<double>({0, gridX, 0, gridY}, [&](int j, int iBegin, int iEnd) {
+        double sum = 0.0;
+        for (int i = iBegin; i < iEnd; i++) {
+            sum += static_cast<double>(a[idx(i, j)]) * b[idx(i, j)];
+        }
+        return sum;
+    });
+}
 
-    const std::vector<float>* field = nullptr;
-    switch (type) {
-        case 0:
-            field = &x;
-            yOffset = halfCellHeight;
-            break;
-        case 1:
-            field = &y;
-            xOffset = halfCellHeight;
-            break;
-        case 2:
-            field = &d;
-            xOffset = halfCellHeight;
-            yOffset = halfCellHeight;
-            break;
-        case 3:
-            field = &r_ink;
-            xOffset = halfCellHeight;
-            yOffset = halfCellHeight;
-            break;
-        case 4:
-            field = &g_ink;
-            xOffset = halfCellHeight;
-            yOffset = halfCellHeight;
-            break;
-        case 5:
-            field = &b_ink;
-            xOffset = halfCellHeight;
-            yOffset = halfCellHeight;
-            break;
-        default:
-            return 0.0f;
+template <typename Real>
+Real BasicFluidSimulator<Real>::maxAbs(const Real* v) {
+    Real result = 0.0f;
+    #pragma omp parallel for reduction(max:result)
+    for (int k = 0; k < layout.size; k++) {
+        result = std::max(result, std::fabs(v[k]));
     }
+    return result;
+}
 
-    int x0 = std::min(static_cast<int>(floor((i-xOffset) / cellHeight)), gridX-1);
-    int x1 = std::min(x0+1, gridX-1);
-
-    int y0 = std::min(static_cast<int>(floor((j-yOffset) / cellHeight)), gridY-1);
-    int y1 = std::min(y0+1, gridY-1);
-
-    float tx = ((i-xOffset) - x0*cellHeight) / cellHeight;
-    float ty = ((j-yOffset) - y0*cellHeight) / cellHeight;
-
-    float sx = 1.0f - tx;
-    float sy = 1.0f - ty;
-
-    float v = sx * sy * (*field)[idx(x0, y0)] +
-            tx * sy * (*field)[idx(x1, y0)] +
-            tx * ty * (*field)[idx(x1, y1)] +
-            sx * ty * (*field)[idx(x0, y1)];
-
-    return v;
+template <typename Real>
+void BasicFluidSimulator<Real>::registerPassiveScalar(FieldHandle field, FieldHandle next, bool isInk) {
+    if (passiveScalars.size() >= MAX_PASSIVE_SCALARS) {
+        std::cerr << "Too many passive scalars, max is " << MAX_PASSIVE_SCALARS << std::endl;
+        return;
+    }
+    passiveScalars.push_back({field, next, isInk});
 }
 
-bool FluidSimulator::isInsideCircle(int i, int j) {
-    float dx = (i + 0.5f) - circleX;
-    float dy = (j + 0.5f) - circleY;
+template <typename Real>
+bool BasicFluidSimulator<Real>::isInsideCircle(int i, int j) {
+    Real dx = (i + 0.5f) - circleX;
+    Real dy = (j + 0.5f) - circleY;
     return sqrt(dx * dx + dy * dy) <= circleRadius;
 }
 
-void FluidSimulator::moveCircle(int newGridX, int newGridY) {
+template <typename Real>
+void BasicFluidSimulator<Real>::moveCircle(int newGridX, int newGridY) {
     prevCircleX = circleX;
     prevCircleY = circleY;
 
-    float instantVelX = (newGridX - circleX) / timeStep;
-    float instantVelY = (newGridY - circleY) / timeStep;
+    Real instantVelX = (newGridX - circleX) / timeStep;
+    Real instantVelY = (newGridY - circleY) / timeStep;
 
     // smoother circle velocity to reduce velocity jitter
     // (doesn't work that well D: )
-    float alpha = 0.3f; // smoothing factor
+    Real alpha = 0.3f; // smoothing factor
     circleVelX = alpha * instantVelX + (1.0f - alpha) * circleVelX;
     circleVelY = alpha * instantVelY + (1.0f - alpha) * circleVelY;
 
@@ -507,17 +1244,67 @@ void FluidSimulator::moveCircle(int newGridX, int newGridY) {
     updateCircle(prevCircleX, prevCircleY, circleX, circleY);
 }
 
-void FluidSimulator::updateCircle(int prevX, int prevY, int newX, int newY) {
-    updateCircleAreas(prevX, prevY, newX, newY);
-    circleMomentumTransfer();
-    setupEdges();
-    enforceBoundaryConditions();
+template <typename Real>
+void BasicFluidSimulator<Real>::updateCircle(int prevX, int prevY, int newX, int newY) {
+    // only the box around the old and new circle changed solidity; the push reaches
+    // further, and its faces next to any solid (circle, frame, image) are cleared again
+    CellRange dirty = updateCircleAreas(prevX, prevY, newX, newY);
+    CellRange pushed = circleMomentumTransfer(prevX, prevY);
+    setupEdges(dirty);
+    enforceBoundaryConditions(unite(dirty, pushed));
+    obstaclesDirty = unite(obstaclesDirty, dirty);
 }
 
-void FluidSimulator::enforceBoundaryConditions() {
-    // clear velocity in all solid cells and their neighboring velocity components
-    for (int i = 0; i < gridX; i++) {
-        for (int j = 0; j < gridY; j++) {
+template <typename Real>
+void BasicFluidSimulator<Real>::rebuildCellFlags() {
+    // the neighbors of an edited cell see their flags change too
+    CellRange range = {std::max(0, obstaclesDirty.iBegin - 1), std::min(gridX, obstaclesDirty.iEnd + 1),
+                       std::max(0, obstaclesDirty.jBegin - 1), std::min(gridY, obstaclesDirty.jEnd + 1)};
+    buildCellFlags(s, layout, cellFlags, range);
+    wakeAllTiles = true;
+    if (projectionSolver == ProjectionSolver::MULTIGRID) {
+        multigrid.setCellFlags(cellFlags);
+    }
+    obstaclesDirty = {0, 0, 0, 0};
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::bindFields() {
+    x = fieldData(xField);
+    y = fieldData(yField);
+    newX = fieldData(newXField);
+    newY = fieldData(newYField);
+    s = fieldData(sField);
+    cellFlags = flagsField == INVALID_FIELD ? nullptr : arena.get<uint8_t>(flagsField);
+    p = fieldData(pField);
+    d = scalarField(dField);
+    w = fieldData(wField);
+    solverCorrection = fieldData(correctionField);
+    solverResidual = fieldData(residualField);
+    pcgAux = fieldData(pcgAuxField);
+    pcgSearch = fieldData(pcgSearchField);
+    pcgPrecon = fieldData(pcgPreconField);
+}
+
+template <typename Real>
+FieldView BasicFluidSimulator<Real>::realView(FieldHandle field) const {
+    if (std::is_same<Real, float>::value || field == INVALID_FIELD) return arena.view(field);
+
+    // renderers read floats; double fields are narrowed into a mirror on every request
+    const Real* data = arena.get<Real>(field);
+    std::vector<float>& mirror = floatMirrors[field];
+    mirror.resize(arena.getElementCount());
+    for (size_t k = 0; k < mirror.size(); k++) {
+        mirror[k] = static_cast<float>(data[k]);
+    }
+    return FieldView(mirror.data(), mirror.size());
+}
+
+template <typename Real>
+void BasicFluidSimulator<Real>::enforceBoundaryConditions(const CellRange& range) {
+    // clear velocity in the solid cells of range and their neighboring velocity components
+    traversal.forEachRowSerial(range, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
             if (s[idx(i, j)] == 0.0f) {
                 // clear velocity in the solid cell
                 x[idx(i, j)] = 0.0f;
@@ -528,166 +1315,145 @@ void FluidSimulator::enforceBoundaryConditions() {
                 if (j < gridY-1) y[idx(i, j+1)] = 0.0f;
             }
         }
-    }
+    });
 
     // preserve wind tunnel velocity
-    if (windTunnelSide != -1) {
-
-        switch (windTunnelSide) {
-            case 0: // left
-                for (int j = windTunnelStartCell; j < windTunnelEndCell; j++) {
-                    if (j >= 0 && j < gridY) {
-                        x[idx(1, j)] = windTunnelVelocity;
-                    }
-                }
-                break;
-            case 1: // top
-                for (int i = windTunnelStartCell; i < windTunnelEndCell; i++) {
-                    if (i >= 0 && i < gridX) {
-                        y[idx(i, gridY-1)] = -windTunnelVelocity;
-                    }
-                }
-                break;
-            case 2: // bottom
-                for (int i = windTunnelStartCell; i < windTunnelEndCell; i++) {
-                    if (i >= 0 && i < gridX) {
-                        y[idx(i, 1)] = windTunnelVelocity;
-                    }
-                }
-                break;
-            case 3: // right
-                for (int j = windTunnelStartCell; j < windTunnelEndCell; j++) {
-                    if (j >= 0 && j < gridY) {
-                        x[idx(gridX-1, j)] = -windTunnelVelocity;
-                    }
-                }
-                break;
-        }
-    }
+    imposeBoundaries(false);
 }
 
 
-void FluidSimulator::circleMomentumTransfer() {
+template <typename Real>
+CellRange BasicFluidSimulator<Real>::circleMomentumTransfer(int prevX, int prevY) {
     if (fabs(circleVelX) < 0.001f && fabs(circleVelY) < 0.001f) {
-        return;
+        return {0, 0, 0, 0};
     }
 
-    float effectiveRadius = circleRadius + momentumTransferRadius;
-
-    // apply momentum to fluid cells near the ball surface
-    for (int i = circleX - static_cast<int>(effectiveRadius) - 1;
-         i <= circleX + static_cast<int>(effectiveRadius) + 1; i++) {
-        for (int j = circleY - static_cast<int>(effectiveRadius) - 1;
-             j <= circleY + static_cast<int>(effectiveRadius) + 1; j++) {
-
-            if (i >= 0 && i < gridX && j >= 0 && j < gridY) {
-                if (s[idx(i, j)] == 0.0f) continue;
-
-                float dx = (i + 0.5f) - circleX;
-                float dy = (j + 0.5f) - circleY;
-                float distance = sqrt(dx * dx + dy * dy);
+    Real effectiveRadius = circleRadius + momentumTransferRadius;
+
+    // apply momentum to fluid cells near the path the ball swept since (prevX, prevY);
+    // cells it passed over get the full push. drags are coalesced into one move per step,
+    // so this is one deposit along the whole path, not one per drag event. only momentum
+    // follows the path: the solid mask jumps from the old disc to the new one
+    int reach = static_cast<int>(effectiveRadius) + 1;
+    CellRange box = {std::max(0, std::min(prevX, circleX) - reach),
+                     std::min(gridX, std::max(prevX, circleX) + reach + 1),
+                     std::max(0, std::min(prevY, circleY) - reach),
+                     std::min(gridY, std::max(prevY, circleY) + reach + 1)};
+    Real pathX = circleX - prevX;
+    Real pathY = circleY - prevY;
+    Real pathLength2 = pathX * pathX + pathY * pathY;
+    traversal.forEachRowSerial(box, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            if (s[idx(i, j)] == 0.0f) continue;
+
+            // distance to the closest point of the path
+            Real t = 0.0f;
+            if (pathLength2 > 0.0f) {
+                t = ((i + 0.5f - prevX) * pathX + (j + 0.5f - prevY) * pathY) / pathLength2;
+                t = std::max(Real(0), std::min(Real(1), t));
+            }
+            Real dx = (i + 0.5f) - (prevX + t * pathX);
+            Real dy = (j + 0.5f) - (prevY + t * pathY);
+            Real distance = sqrt(dx * dx + dy * dy);
 
-                // within influence radius but outside ball
-                if (distance > circleRadius && distance <= effectiveRadius) {
-                    // falloff is 1/r^2
-                    float normalizedDistance = (distance - circleRadius) / momentumTransferRadius;
-                    float falloff = 1.0f - normalizedDistance * normalizedDistance;
-                    falloff = std::max(0.0f, falloff);
+            // within influence radius of the swept segment, ball included
+            if (distance <= effectiveRadius) {
+                // falloff is 1/r^2
+                Real normalizedDistance = std::max(Real(0), distance - circleRadius) / momentumTransferRadius;
+                Real falloff = 1.0f - normalizedDistance * normalizedDistance;
+                falloff = std::max(Real(0), falloff);
 
-                    float densityFactor = d[idx(i, j)]; // weight velocity imparted by local density
+                Real densityFactor = d.get(idx(i, j)); // weight velocity imparted by local density
 
-                    float momentumX = circleVelX * momentumTransferCoeff * falloff * densityFactor;
-                    float momentumY = circleVelY * momentumTransferCoeff * falloff * densityFactor;
+                Real momentumX = circleVelX * momentumTransferCoeff * falloff * densityFactor;
+                Real momentumY = circleVelY * momentumTransferCoeff * falloff * densityFactor;
 
-                    x[idx(i, j)] += momentumX;
-                    y[idx(i, j)] += momentumY;
+                x[idx(i, j)] += momentumX;
+                y[idx(i, j)] += momentumY;
 
-                    // clamp velocities to prevent instability
-                    float maxVel = 8.0f;
-                    x[idx(i, j)] = std::max(-maxVel, std::min(maxVel, x[idx(i, j)]));
-                    y[idx(i, j)] = std::max(-maxVel, std::min(maxVel, y[idx(i, j)]));
-                }
+                // clamp velocities to prevent instability
+                Real maxVel = 8.0f;
+                x[idx(i, j)] = std::max(-maxVel, std::min(maxVel, x[idx(i, j)]));
+                y[idx(i, j)] = std::max(-maxVel, std::min(maxVel, y[idx(i, j)]));
             }
         }
-    }
+    });
+
+    // cells whose solidity decides the pushed faces: x(i, j) and y(i, j) also border
+    // cells (i-1, j) and (i, j-1)
+    return {std::max(0, box.iBegin - 1), box.iEnd, std::max(0, box.jBegin - 1), box.jEnd};
 }
 
-void FluidSimulator::updateCircleAreas(int prevX, int prevY, int newX, int newY) {
+template <typename Real>
+CellRange BasicFluidSimulator<Real>::updateCircleAreas(int prevX, int prevY, int newX, int newY) {
     // bounding box surrounding new and old circles
     int minI = std::min(prevX - circleRadius, newX - circleRadius);
     int maxI = std::max(prevX + circleRadius, newX + circleRadius);
     int minJ = std::min(prevY - circleRadius, newY - circleRadius);
     int maxJ = std::max(prevY + circleRadius, newY + circleRadius);
 
-    for (int i = minI; i <= maxI; i++) {
-        for (int j = minJ; j <= maxJ; j++) {
-            if (i >= 0 && i < gridX && j >= 0 && j < gridY) {
-                float dx = (i + 0.5f);
-                float dy = (j + 0.5f);
-
-                float prevDx = dx - prevX;
-                float prevDy = dy - prevY;
-                float distPrev = sqrt(prevDx * prevDx + prevDy * prevDy);
-
-                float newDx = dx - newX;
-                float newDy = dy - newY;
-                float distNew = sqrt(newDx * newDx + newDy * newDy);
-
-                bool wasInPrevCircle = distPrev <= circleRadius;
-                bool isInNewCircle = distNew <= circleRadius;
-
-                if (wasInPrevCircle && !isInNewCircle) {
-                    s[idx(i, j)] = 1.0f; // make it fluid again
-                    d[idx(i, j)] = 1.0f; // reset to default density
-                    x[idx(i, j)] = 0.0f; // clear velocity
-                    y[idx(i, j)] = 0.0f;
-                } else if (!wasInPrevCircle && isInNewCircle) {
-                    s[idx(i, j)] = 0.0f; // make it solid
-                    // don't touch density -- this fixed the wisp !!!
-                }
+    CellRange box = {std::max(0, minI), std::min(gridX, maxI + 1),
+                     std::max(0, minJ), std::min(gridY, maxJ + 1)};
+    traversal.forEachRowSerial(box, [&](int j, int iBegin, int iEnd) {
+        for (int i = iBegin; i < iEnd; i++) {
+            Real dx = (i + 0.5f);
+            Real dy = (j + 0.5f);
+
+            Real prevDx = dx - prevX;
+            Real prevDy = dy - prevY;
+            Real distPrev = sqrt(prevDx * prevDx + prevDy * prevDy);
+
+            Real newDx = dx - newX;
+            Real newDy = dy - newY;
+            Real distNew = sqrt(newDx * newDx + newDy * newDy);
+
+            bool wasInPrevCircle = distPrev <= circleRadius;
+            bool isInNewCircle = distNew <= circleRadius;
+
+            if (wasInPrevCircle && !isInNewCircle) {
+                s[idx(i, j)] = 1.0f; // make it fluid again
+                d.set(idx(i, j), 1.0f); // reset to default density
+                x[idx(i, j)] = 0.0f; // clear velocity
+                y[idx(i, j)] = 0.0f;
+            } else if (!wasInPrevCircle && isInNewCircle) {
+                s[idx(i, j)] = 0.0f; // make it solid
+                // don't touch density -- this fixed the wisp !!!
             }
         }
-    }
+    });
+    return box;
 }
 
-
-void FluidSimulator::onMouseDrag(int gridX, int gridY) {
+template <typename Real>
+void BasicFluidSimulator<Real>::onMouseDrag(int gridX, int gridY) {
     if (isDragging) {
         // clamp circle to bounds
         int newX = std::max(circleRadius, std::min(gridX, this->gridX - circleRadius - 1));
         int newY = std::max(circleRadius, std::min(gridY, this->gridY - circleRadius - 1));
 
-        if (newX != circleX || newY != circleY) {
-            moveCircle(newX, newY);
-        }
+        // drags are coalesced: update() moves the circle once per step, to the last target
+        circleMovePending = newX != circleX || newY != circleY;
+        targetCircleX = newX;
+        targetCircleY = newY;
     }
 }
 
-void FluidSimulator::onMouseDown(int gridX, int gridY) {
+template <typename Real>
+void BasicFluidSimulator<Real>::onMouseDown(int gridX, int gridY) {
     isDragging = true;
 }
 
-void FluidSimulator::onMouseUp() {
+template <typename Real>
+void BasicFluidSimulator<Real>::onMouseUp() {
     isDragging = false;
 }
 
-bool FluidSimulator::shouldSkipInkCell(int i, int j, bool checkNoInk) const {
-    // skip solid cells
-    if (s[idx(i, j)] == 0.0f) return true;
+template class BasicFluidSimulator<float>;
+template class BasicFluidSimulator<double>;
 
-    // skip wind tunnels
-    int cy = gridY / 2;
-    if (i == 1 && j >= cy - pipeHeight / 2 && j < cy + pipeHeight / 2) {
-        return true;
+std::unique_ptr<ISimulator> createFluidSimulator(const Config& config) {
+    if (config.simulation.realType == RealType::DOUBLE) {
+        return std::make_unique<BasicFluidSimulator<double>>(config);
     }
-
-    // skip cells with no ink
-    if (checkNoInk) {
-        int idx_ij = idx(i, j);
-        if (r_ink[idx_ij] == 0.0f && g_ink[idx_ij] == 0.0f && b_ink[idx_ij] == 0.0f) {
-            return true;
-        }
-    }
-
-    return false;
+    return std::make_unique<FluidSimulator>(config);
 }
@@ -1,14 +1,27 @@
 #ifndef FLUID_SIMULATOR_H
 #define FLUID_SIMULATOR_H
 
+#include <memory>
 #include <vector>
 #include "isimulator.h"
 #include "config.h"
+#include "multigrid.h"
+#include "sampler.h"
+#include "advect_kernels.h"
+#include "cell_flags.h"
+#include "grid_layout.h"
+#include "grid_traversal.h"
+#include "activity_map.h"
+#include "field_arena.h"
 
-class FluidSimulator : public ISimulator {
+// the CPU simulator; Real is the scalar type of velocity, pressure, the solvers and the
+// advection math (float, or double for validation runs). density and ink keep their
+// simulation.scalarPrecision storage, and every view handed out is float
+template <typename Real>
+class BasicFluidSimulator : public ISimulator {
 public:
-    FluidSimulator(const Config& config);
-    ~FluidSimulator();
+    BasicFluidSimulator(const Config& config);
+    ~BasicFluidSimulator();
 
     void init(const Config& config, const ImageData* imageData = nullptr) override;
     void update() override;
@@ -21,38 +34,90 @@ public:
 
     int getGridX() const override { return gridX; }
     int getGridY() const override { return gridY; }
-    float getCellSize() const override { return cellHeight; }
+    int getFieldStride() const override { return layout.stride; }
+    int getFieldOffset() const override { return layout.origin; }
+    float getCellSize() const override { return static_cast<float>(cellHeight); }
     float getDomainWidth() const override { return domainWidth; }
     float getDomainHeight() const override { return domainHeight; }
   
-    const std::vector<float>& getVelocityX() const override { return x; }
-    const std::vector<float>& getVelocityY() const override { return y; }
-    const std::vector<float>& getPressure() const override { return p; }
-    const std::vector<float>& getDensity() const override { return d; }
-    const std::vector<float>& getSolid() const override { return s; }
-    const std::vector<float>& getRedInk() const override { return r_ink; }
-    const std::vector<float>& getGreenInk() const override { return g_ink; }
-    const std::vector<float>& getBlueInk() const override { return b_ink; }
+    FieldView getVelocityX() const override { return realView(xField); }
+    FieldView getVelocityY() const override { return realView(yField); }
+    FieldView getPressure() const override { return realView(pField); }
+    FieldView getDensity() const override { return arena.view(dField); }
+    FieldView getSolid() const override { return realView(sField); }
+    FieldView getRedInk() const override { return arena.view(redInkField); }
+    FieldView getGreenInk() const override { return arena.view(greenInkField); }
+    FieldView getBlueInk() const override { return arena.view(blueInkField); }
+    FieldView getVorticity() const override { return realView(wField); }
     bool isInkInitialized() const override { return inkInitialized; }
 
+    int getProjectionIterations() const override { return projectionIterations; }
+    float getProjectionResidual() const override { return static_cast<float>(projectionResidual); }
+    float getActiveTileFraction() const override { return activity.activeFraction(); }
+    const std::vector<Real>& getProjectionResidualHistory() const { return multigrid.getResidualHistory(); }
+    const char* getAdvectionKernel() const { return simdLevelName(simdLevel); }
+    const FieldArena& getFieldArena() const { return arena; }
+    std::vector<StageStats> getStageStats() const override { return profiler.getStats(); }
+    void resetStageStats() override { profiler.reset(); }
+
 private:
+    // katara_tests reaches single stages and setup helpers through this
+    friend struct SimulatorTestAccess;
+
     // grid params
     int resolution;
     int gridX, gridY;
     float domainHeight, domainWidth;
-    float cellHeight, halfCellHeight;
-    float xHeight, yHeight;
+    Real cellHeight, halfCellHeight;
+    Real xHeight, yHeight;
+    GridLayout layout; // padded storage shared by every field
+    GridTraversal traversal; // loop order and tiling of every grid kernel
+
+    // tiles advection and vorticity skip because the step can't change them by more
+    // than activityTolerance; every tile is active while tracking is off
+    bool activityEnabled;
+    Real activityTolerance;
+    int activityTileSize;
+    bool wakeAllTiles; // obstacles changed since the last classification
+    ActivityMap activity;
+    struct TileStats {
+        Real speed; // max |u|, |v|
+        Real lo[2 + MAX_PASSIVE_SCALARS]; // bounds of u, v and each passive scalar
+        Real hi[2 + MAX_PASSIVE_SCALARS];
+    };
+    std::vector<TileStats> tileStats;
 
     // sim params
-    float timeStep;
-    float gravity;
-    float density;
-    float pressureMultiplier;
-    float overrelaxationCoefficient;
+    Real timeStep;
+    Real gravity;
+    Real density;
+    Real pressureMultiplier;
+    ProjectionSolver projectionSolver;
+    Real overrelaxationCoefficient;
     int gsIterations;
+    Real projectionTolerance;
+    int projectionMaxIterations;
+    bool warmStart;
+    bool earlyExit;
+    Real divergenceOffset;
+    int multigridCycle;
+    int smoothingIterations;
+    int blockDepth; // SOR sweeps per wavefront block
+    int projectionIterations;
+    Real projectionResidual;
     bool doVorticity;
-    float vorticity;
-    float vorticityLen;
+    bool curlNeeded; // vorticity confinement or vorticity rendering
+    Real vorticity;
+    Real vorticityLen;
+    SimdLevel simdLevel; // requested in config, selected in init
+    BasicAdvectRowKernel<Real> advectRowKernel;
+
+    // update() runs a step compiled for the features picked in init, so the stage
+    // sequence carries no per-step flag checks
+    enum StepFeature : unsigned { STEP_GRAVITY = 1, STEP_CURL = 2, STEP_VORTICITY = 4, STEP_ACTIVITY = 8 };
+    typedef void (BasicFluidSimulator::*StepFunction)();
+    StepFunction stepFunction;
+    ScalarPrecision scalarPrecision; // storage of density and ink
 
     // wind tunnel state
     float windTunnelStart; // 0-1 (pass this one in)
@@ -61,66 +126,155 @@ private:
     int windTunnelEndCell;
     int pipeHeight;
     int windTunnelSide; // 0, 1, 2, 3 = left, top, bottom, right; -1 = disabled
-    float windTunnelVelocity; // magnitude; direction inferred
+    Real windTunnelVelocity; // magnitude; direction inferred
+
+    // openings (wind tunnel first, then simulation.boundaries) as index lists built in
+    // init, so imposing them costs O(perimeter). faces are the x faces of a left/right
+    // opening or the y faces of a top/bottom one, between the edge cell and the first
+    // fluid cell; inward steps to the next interior face. the edge cells of an outflow
+    // are fluid but never relaxed, so the projection sees them as zero pressure
+    // (Dirichlet) cells and can push mass out through the faces
+    struct Boundary {
+        bool outflow;
+        bool alongX;
+        Real velocity; // signed, inflows only
+        int inward;
+        std::vector<int> faces;
+        std::vector<int> cells; // edge cells: inlets kept free of smoke, or open outlets
+    };
+    std::vector<Boundary> boundaries;
+    std::vector<int> edgeCells; // the solid frame of the domain; outflows reopen their cells
+    bool hasOutflow; // the pressure problem has Dirichlet cells, so it is definite
 
     // momentum transfer parameters
-    float momentumTransferCoeff;
-    float momentumTransferRadius;
+    Real momentumTransferCoeff;
+    Real momentumTransferRadius;
+
+    // every field lives in one arena and is named by a handle (INVALID_FIELD when
+    // unused); the raw pointers below are rebound by bindFields() whenever the arena
+    // allocates or swaps buffers
+    FieldArena arena;
+    mutable std::vector<std::vector<float>> floatMirrors; // per field, narrowed copies for double views
+    bool hugePages; // ask for transparent huge pages when the arena is large enough
+    FieldHandle xField = INVALID_FIELD, yField = INVALID_FIELD;
+    FieldHandle newXField = INVALID_FIELD, newYField = INVALID_FIELD;
+    FieldHandle sField = INVALID_FIELD, flagsField = INVALID_FIELD;
+    FieldHandle pField = INVALID_FIELD, dField = INVALID_FIELD;
+    FieldHandle wField = INVALID_FIELD;
+    FieldHandle correctionField = INVALID_FIELD, residualField = INVALID_FIELD;
+    FieldHandle pcgAuxField = INVALID_FIELD, pcgSearchField = INVALID_FIELD, pcgPreconField = INVALID_FIELD;
+    FieldHandle redInkField = INVALID_FIELD, greenInkField = INVALID_FIELD, blueInkField = INVALID_FIELD;
 
-    std::vector<float> x; // x vel field
-    std::vector<float> y; // y vel field
-    std::vector<float> s; // solid field (1 = fluid, 0 = solid)
-    std::vector<float> p; // pressure field
-    std::vector<float> d; // density field
+    Real* x; // x vel field
+    Real* y; // y vel field
+    Real* s; // solid field (1 = fluid, 0 = solid)
+    uint8_t* cellFlags; // stencil flags derived from s, used by the hot loops
+    CellRange obstaclesDirty; // cells whose s was edited since cellFlags was built
+    Real* p; // pressure field
+    ScalarField d; // density field, stored in scalarPrecision
+    Real* w; // curl field, cached once per step
 
-    // advection util arrays
-    std::vector<float> newX, newY, newD;
-    std::vector<float> new_r_ink, new_g_ink, new_b_ink;
+    // advection back buffers
+    Real* newX;
+    Real* newY;
+
+    // PCG/multigrid solver arrays
+    Real* solverCorrection;
+    Real* solverResidual;
+    Real* pcgAux;
+    Real* pcgSearch;
+    Real* pcgPrecon;
+    BasicMultigridSolver<Real> multigrid;
 
     // ink diffusion
-    std::vector<float> r_ink, g_ink, b_ink;
     bool inkInitialized;
 
+    // cell-centered fields advected together with one backtrace per cell
+    struct PassiveScalar {
+        FieldHandle field;
+        FieldHandle next;
+        bool isInk; // ink skips wind tunnel and empty cells
+    };
+    std::vector<PassiveScalar> passiveScalars;
+
+    // bilinear field sampling for advection
+    BasicGridSampler<Real> sampler;
+
     // configuration
     bool domainSetByImage;
 
+    // stage timings of update(), indexed by Stage
+    enum Stage { STAGE_STEP, STAGE_INTEGRATE, STAGE_PROJECT, STAGE_EXTRAPOLATE, STAGE_ACTIVITY, STAGE_ADVECT,
+                 STAGE_VORTICITY };
+    StageProfiler profiler;
+
     // circle state
     int circleX, circleY;
     int prevCircleX, prevCircleY;
-    float circleVelX, circleVelY;
+    Real circleVelX, circleVelY;
     int circleRadius;
     bool isDragging;
+    bool circleMovePending; // latest drag target, applied once by the next update()
+    int targetCircleX, targetCircleY;
 
     // circle movement
     void setupCircle();
     void moveCircle(int newGridX, int newGridY);
     void updateCircle(int prevX, int prevY, int newX, int newY);
-    void enforceBoundaryConditions();
-    void circleMomentumTransfer();
-    void setupEdges();
-    void updateCircleAreas(int prevX, int prevY, int newX, int newY);
+    void enforceBoundaryConditions(const CellRange& range);
+    CellRange circleMomentumTransfer(int prevX, int prevY); // returns the cells bordering the pushed faces
+    void setupEdges(const CellRange& range);
+    void buildBoundaries(const Config& config);
+    void imposeBoundaries(bool clearSmoke);
+    CellRange updateCircleAreas(int prevX, int prevY, int newX, int newY);
+    void rebuildCellFlags();
+    void bindFields();
 
     // sim steps
+    template <unsigned Features> void step();
     void integrate();
     void project();
+    void projectGaussSeidel();
+    void projectRedBlack();
+    void sweepWavefront(int sweeps, bool redBlack);
+    void projectPCG();
+    void projectMultigrid();
+    void buildPressureRHS(Real* rhs);
+    Real meanDivergence();
+    void warmStartCorrection();
+    void applyPressureCorrection(const Real* q);
     void extrapolate();
+    template <typename T> void fillGhostCells(T* field);
+    void classifyActivity();
     void advect();
+    void computeCurl();
     void applyVorticity();
 
     // grid utils
-    float div(int i, int j);
-    float curl(int i, int j);
-    float clamp(float n, float min, float max);
-    float neighborhoodX(int i, int j);
-    float neighborhoodY(int i, int j);
-    float sample(float i, float j, int type);
+    Real div(int i, int j);
+    Real relaxCell(int i, int j);
+    Real valence(int i, int j);
+    void buildPreconditioner();
+    void applyPreconditioner(const Real* r, Real* z);
+    void applyLaplacian(const Real* v, Real* out);
+    double dot(const Real* a, const Real* b);
+    Real maxAbs(const Real* v);
+    Real curl(int i, int j);
+    void registerPassiveScalar(FieldHandle field, FieldHandle next, bool isInk);
 
     // image initialization helpers
     void initializeFromImageData(const Config& config, const ImageData* imageData);
 
     // misc helpers
-    bool shouldSkipInkCell(int i, int j, bool checkNoInk = true) const;
-    int idx(int i, int j) const { return j * gridX + i; }
+    int idx(int i, int j) const { return layout.idx(i, j); }
+    Real* fieldData(FieldHandle field) { return field == INVALID_FIELD ? nullptr : arena.get<Real>(field); }
+    FieldView realView(FieldHandle field) const;
+    ScalarField scalarField(FieldHandle field) { return {field == INVALID_FIELD ? nullptr : arena.get<void>(field), scalarPrecision}; }
 };
 
+typedef BasicFluidSimulator<float> FluidSimulator;
+
+// FluidSimulator or its double instantiation, as picked by simulation.realType
+std::unique_ptr<ISimulator> createFluidSimulator(const Config& config);
+
 #endif
\ No newline at end of file
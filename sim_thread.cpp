@@ -0,0 +1,157 @@
+#include "sim_thread.h"
+#include <chrono>
+#include <cstring>
+
+FieldSnapshot::FieldSnapshot()
+    : step(0), gridX(0), gridY(0), fieldStride(0), fieldOffset(0), cellSize(1.0f),
+      domainWidth(0.0f), domainHeight(0.0f), inkInitialized(false), projectionIterations(0),
+      projectionResidual(0.0f), activeTileFraction(1.0f) {}
+
+void FieldSnapshot::capture(const ISimulator& source, long long step) {
+    this->step = step;
+    gridX = source.getGridX();
+    gridY = source.getGridY();
+    fieldStride = source.getFieldStride();
+    fieldOffset = source.getFieldOffset();
+    cellSize = source.getCellSize();
+    domainWidth = source.getDomainWidth();
+    domainHeight = source.getDomainHeight();
+
+    copyField(FIELD_VELOCITY_X, source.getVelocityX());
+    copyField(FIELD_VELOCITY_Y, source.getVelocityY());
+    copyField(FIELD_PRESSURE, source.getPressure());
+    copyField(FIELD_DENSITY, source.getDensity());
+    copyField(FIELD_SOLID, source.getSolid());
+    copyField(FIELD_RED_INK, source.getRedInk());
+    copyField(FIELD_GREEN_INK, source.getGreenInk());
+    copyField(FIELD_BLUE_INK, source.getBlueInk());
+    copyField(FIELD_VORTICITY, source.getVorticity());
+    inkInitialized = source.isInkInitialized();
+
+    projectionIterations = source.getProjectionIterations();
+    projectionResidual = source.getProjectionResidual();
+    activeTileFraction = source.getActiveTileFraction();
+    stageStats = source.getStageStats();
+}
+
+void FieldSnapshot::copyField(Field field, const FieldView& source) {
+    FieldCopy& copy = fields[field];
+    copy.count = source.size();
+    copy.precision = source.precision();
+    copy.bytes.resize(source.size() * source.elementBytes());
+    if (!copy.bytes.empty()) {
+        std::memcpy(copy.bytes.data(), source.data(), copy.bytes.size());
+    }
+}
+
+FieldView FieldSnapshot::view(Field field) const {
+    const FieldCopy& copy = fields[field];
+    if (copy.count == 0) return FieldView();
+    return FieldView(copy.bytes.data(), copy.count, copy.precision);
+}
+
+SimulationThread::SimulationThread(std::unique_ptr<ISimulator> simulator, float timestep, bool paced)
+    : simulator(std::move(simulator)), timestep(timestep), paced(paced), back(2), front(0), middle(1),
+      running(false), steps(0) {}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running) return;
+    // the renderer has the initial state before the first step completes
+    slots[front].capture(*simulator, steps);
+    running = true;
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+const FieldSnapshot& SimulationThread::latest() {
+    if (middle.load(std::memory_order_relaxed) & FRESH) {
+        // acquire: the simulation thread's writes to the slot are visible
+        front = middle.exchange(front, std::memory_order_acq_rel) & SLOT_MASK;
+    }
+    return slots[front];
+}
+
+void SimulationThread::onMouseDown(int gridX, int gridY) {
+    post({INPUT_DOWN, gridX, gridY});
+}
+
+void SimulationThread::onMouseDrag(int gridX, int gridY) {
+    post({INPUT_DRAG, gridX, gridY});
+}
+
+void SimulationThread::onMouseUp() {
+    post({INPUT_UP, 0, 0});
+}
+
+void SimulationThread::post(const Input& input) {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    inputs.push_back(input);
+}
+
+void SimulationThread::applyInputs() {
+    std::vector<Input> pending;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        pending.swap(inputs);
+    }
+    for (const Input& input : pending) {
+        switch (input.type) {
+            case INPUT_DOWN:
+                if (simulator->isInsideCircle(input.gridX, input.gridY)) {
+                    simulator->onMouseDown(input.gridX, input.gridY);
+                }
+                break;
+            case INPUT_DRAG:
+                simulator->onMouseDrag(input.gridX, input.gridY);
+                break;
+            case INPUT_UP:
+                simulator->onMouseUp();
+                break;
+        }
+    }
+}
+
+void SimulationThread::run() {
+    typedef std::chrono::steady_clock Clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(timestep));
+    auto next = Clock::now();
+
+    while (running) {
+        applyInputs();
+        simulator->update();
+        steps++;
+
+        // real time pacing; a step that overran starts the next one right away
+        bool sleeps = false;
+        if (paced) {
+            next += period;
+            auto now = Clock::now();
+            if (next > now) {
+                sleeps = true;
+            } else {
+                next = now;
+            }
+        }
+
+        // while the middle slot holds a step the renderer hasn't taken, a newer one would
+        // replace it unseen, so only the last step before the thread sleeps is copied
+        if (sleeps || !(middle.load(std::memory_order_relaxed) & FRESH)) {
+            // release: the slot is complete before the renderer can swap it in
+            slots[back].capture(*simulator, steps);
+            back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & SLOT_MASK;
+        }
+        if (sleeps) {
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "isimulator.h"
+
+// a copy of everything the renderers read from a simulator after one completed step.
+// it is an ISimulator so renderers draw it like the live simulator; stepping and mouse
+// input do nothing, and views stay valid until the next capture into this snapshot
+class FieldSnapshot : public ISimulator {
+public:
+    FieldSnapshot();
+
+    // copies the source's fields after its step-th update, reusing this snapshot's
+    // buffers once they are sized
+    void capture(const ISimulator& source, long long step);
+    long long getStep() const { return step; }
+
+    void init(const Config&, const ImageData* = nullptr) override {}
+    void update() override {}
+    void onMouseDown(int, int) override {}
+    void onMouseDrag(int, int) override {}
+    void onMouseUp() override {}
+    bool isInsideCircle(int, int) override { return false; }
+
+    int getGridX() const override { return gridX; }
+    int getGridY() const override { return gridY; }
+    int getFieldStride() const override { return fieldStride; }
+    int getFieldOffset() const override { return fieldOffset; }
+    float getCellSize() const override { return cellSize; }
+    float getDomainWidth() const override { return domainWidth; }
+    float getDomainHeight() const override { return domainHeight; }
+
+    FieldView getVelocityX() const override { return view(FIELD_VELOCITY_X); }
+    FieldView getVelocityY() const override { return view(FIELD_VELOCITY_Y); }
+    FieldView getPressure() const override { return view(FIELD_PRESSURE); }
+    FieldView getDensity() const override { return view(FIELD_DENSITY); }
+    FieldView getSolid() const override { return view(FIELD_SOLID); }
+    FieldView getRedInk() const override { return view(FIELD_RED_INK); }
+    FieldView getGreenInk() const override { return view(FIELD_GREEN_INK); }
+    FieldView getBlueInk() const override { return view(FIELD_BLUE_INK); }
+    FieldView getVorticity() const override { return view(FIELD_VORTICITY); }
+    bool isInkInitialized() const override { return inkInitialized; }
+
+    int getProjectionIterations() const override { return projectionIterations; }
+    float getProjectionResidual() const override { return projectionResidual; }
+    float getActiveTileFraction() const override { return activeTileFraction; }
+    std::vector<StageStats> getStageStats() const override { return stageStats; }
+
+private:
+    enum Field {
+        FIELD_VELOCITY_X, FIELD_VELOCITY_Y, FIELD_PRESSURE, FIELD_DENSITY, FIELD_SOLID,
+        FIELD_RED_INK, FIELD_GREEN_INK, FIELD_BLUE_INK, FIELD_VORTICITY, FIELD_COUNT
+    };
+    struct FieldCopy {
+        std::vector<unsigned char> bytes;
+        size_t count = 0;
+        ScalarPrecision precision = ScalarPrecision::FP32;
+    };
+
+    long long step;
+    int gridX, gridY;
+    int fieldStride, fieldOffset;
+    float cellSize;
+    float domainWidth, domainHeight;
+    FieldCopy fields[FIELD_COUNT];
+    bool inkInitialized;
+    int projectionIterations;
+    float projectionResidual;
+    float activeTileFraction;
+    std::vector<StageStats> stageStats;
+
+    void copyField(Field field, const FieldView& source);
+    FieldView view(Field field) const;
+};
+
+// steps a simulator on its own thread and hands completed steps to the render thread
+// through a lock-free triple buffer of snapshots: the simulator fills the back slot and
+// swaps it with the middle one, the renderer swaps the middle slot to the front when a
+// newer step is there. neither side ever waits for the other, and the front slot is only
+// touched by the render thread. paced steps follow the timestep in wall clock time, so a
+// fast simulator runs in real time and a slow one runs back to back; unpaced steps always
+// run back to back.
+//
+// a step is only copied into the back slot when the renderer has taken the previous one
+// or the thread is about to sleep, so steps run back to back (behind schedule, or
+// unpaced) don't pay for copies nobody reads; getStep() of the snapshots may skip steps.
+//
+// mouse input is queued and applied by the simulation thread before its next step
+class SimulationThread {
+public:
+    // simulator must already be initialized
+    SimulationThread(std::unique_ptr<ISimulator> simulator, float timestep, bool paced = true);
+    ~SimulationThread();
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();
+
+    // render thread: the newest completed step, valid until the next call
+    const FieldSnapshot& latest();
+
+    // render thread: queued for the simulation thread; mouse down only grabs the
+    // circle when (gridX, gridY) is inside it
+    void onMouseDown(int gridX, int gridY);
+    void onMouseDrag(int gridX, int gridY);
+    void onMouseUp();
+
+private:
+    enum InputType { INPUT_DOWN, INPUT_DRAG, INPUT_UP };
+    struct Input {
+        InputType type;
+        int gridX, gridY;
+    };
+
+    // slot index in the low bits, set while the middle slot holds a step the
+    // renderer hasn't picked up yet
+    static constexpr unsigned FRESH = 4;
+    static constexpr unsigned SLOT_MASK = 3;
+
+    std::unique_ptr<ISimulator> simulator;
+    float timestep;
+    bool paced;
+    FieldSnapshot slots[3];
+    int back, front; // owned by the simulation and render thread
+    std::atomic<unsigned> middle;
+
+    std::mutex inputMutex;
+    std::vector<Input> inputs;
+
+    std::thread thread;
+    std::atomic<bool> running;
+    long long steps;
+
+    void run();
+    void applyInputs();
+    void post(const Input& input);
+};
+
+#endif